@@ -0,0 +1,911 @@
+#include "builders.h"
+#include "iir_coeff.h"
+
+#include <cmath>
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+using std::string;
+using std::cerr;
+using std::endl;
+using std::vector;
+
+// -----------------------------------------------------------------------------
+
+/** Tiled n-th order integral image of each output of a 2D input in the given
+ * accumulation type */
+static RecFilter integral_image(
+        Func input,
+        RecFilterDim x,
+        RecFilterDim y,
+        int order,
+        int tile_width,
+        Type accum,
+        string name)
+{
+    if (x.num_pixels() % tile_width || y.num_pixels() % tile_width || tile_width<=order) {
+        cerr << "Image size " << x.num_pixels() << "x" << y.num_pixels() << " of "
+            << name << " must be a multiple of tile width " << tile_width
+            << " which must be larger than " << order << endl;
+        assert(false);
+    }
+
+    vector<float> coeff = integral_image_coeff(order);
+
+    vector<Expr> values = Tuple(input(x.var(), y.var())).as_vector();
+    for (int i=0; i<values.size(); i++) {
+        values[i] = cast(accum, values[i]);
+    }
+
+    RecFilter S(name);
+    S(x, y) = values;
+    S.add_filter(+x, coeff);
+    S.add_filter(+y, coeff);
+    S.split(x, tile_width, y, tile_width);
+    return S;
+}
+
+/** Check that a stencil with absolute weights summing to stencil_norm applied
+ * to the order-th integral image of a 2D input, divided by divisor, keeps the
+ * precision of the Float(32) result. The order-th integral of an image of ones
+ * reaches C(width-1+order,order)*C(height-1+order,order). Integer images must
+ * be exact: the largest stencil sum must fit the integer accumulation type or
+ * the mantissa of the floating point one. For floating point images the worst
+ * case rounding error of the tiled summation, relative to the largest input,
+ * must be below the resolution of Float(32) */
+static void check_integral_precision(
+        Type input,
+        Type accum,
+        int width,
+        int height,
+        int order,
+        int tile_width,
+        double stencil_norm,
+        double divisor,
+        string name)
+{
+    double magnitude = 1.0;
+    for (int i=1; i<=order; i++) {
+        magnitude *= double(width-1+i)/i * double(height-1+i)/i;
+    }
+
+    int mantissa = (accum.bits()==64 ? 53 : (accum.bits()==32 ? 24 : 11));
+
+    if (input.is_int_or_uint()) {
+        double max_input = (input.is_uint() ?
+                std::ldexp(1.0, input.bits())-1.0 : std::ldexp(1.0, input.bits()-1));
+        double limit = (accum.is_float() ? std::ldexp(1.0, mantissa) :
+                std::ldexp(1.0, accum.is_uint() ? accum.bits() : accum.bits()-1));
+        if (stencil_norm*magnitude*max_input >= limit) {
+            cerr << "Order " << order << " integral image of " << name << " over "
+                << width << "x" << height << " pixels of type " << input
+                << " exceeds the exact range of " << accum << endl;
+            assert(false);
+        }
+    } else {
+        if (!accum.is_float()) {
+            cerr << "Integer accumulation type of " << name << " would truncate "
+                << "the floating point input, use Float(64)" << endl;
+            assert(false);
+        }
+
+        // every integral value is the end of a chain of additions through the
+        // scans inside a tile and the tails of the preceding tiles
+        double additions = order * (double(width)/tile_width +
+                double(height)/tile_width + 2.0*tile_width);
+        double error = stencil_norm * additions * std::ldexp(magnitude, -mantissa) / divisor;
+        if (error > std::ldexp(1.0, -24)) {
+            cerr << "Order " << order << " integral image of " << name << " over "
+                << width << "x" << height << " floating point pixels in " << accum
+                << " has a relative error up to " << error << ", quantize the "
+                << "image to integers for exact accumulation" << endl;
+            assert(false);
+        }
+    }
+}
+
+/** Mean of an output of a first order summed area table over the box of given
+ * radius around (u,v), clipped to the image */
+static Expr box_mean(
+        RecFilter S,
+        int i,
+        Var u,
+        Var v,
+        int radius,
+        int width,
+        int height,
+        Type accum)
+{
+    // box corners clipped to the image, -1 indexes the zero row before the image
+    Expr x0 = clamp(u-radius-1, -1, width -1);
+    Expr x1 = clamp(u+radius,   -1, width -1);
+    Expr y0 = clamp(v-radius-1, -1, height-1);
+    Expr y1 = clamp(v+radius,   -1, height-1);
+
+    auto sat = [&](Expr a, Expr b) {
+        Expr s = S(max(a,0), max(b,0))[i];
+        return select(a<0 || b<0, make_zero(accum), s);
+    };
+
+    Expr sum  = sat(x1,y1) - sat(x0,y1) - sat(x1,y0) + sat(x0,y0);
+    Expr area = (x1-x0) * (y1-y0);
+    return cast<double>(sum) / cast<double>(area);
+}
+
+/** Tile the output function and compute the tiled filter inside its tiles */
+static void schedule_fused_output(Func B, RecFilter S, Var x, Var y, int tile_width) {
+    Var xo("xo"), yo("yo"), xi("xi"), yi("yi");
+
+    Target target = S.target();
+
+    B.compute_root();
+    if (target.has_gpu_feature()) {
+        B.gpu_tile(x, y, xo, yo, xi, yi, tile_width, tile_width);
+        S.compute_at(B, xo);
+        S.gpu_auto_schedule();
+    } else {
+        B.tile(x, y, xo, yo, xi, yi, tile_width, tile_width)
+            .parallel(yo)
+            .vectorize(xi, target.natural_vector_size<float>());
+        S.compute_at(B, xo);
+        S.cpu_auto_schedule();
+    }
+}
+
+/** Tile the output function and compute the tiled filter once at root */
+static void schedule_root_output(Func B, RecFilter S, Var x, Var y, int tile_width) {
+    Var xo("xo"), yo("yo"), xi("xi"), yi("yi");
+
+    Target target = S.target();
+
+    B.compute_root();
+    if (target.has_gpu_feature()) {
+        B.gpu_tile(x, y, xo, yo, xi, yi, tile_width, tile_width);
+        S.gpu_auto_schedule();
+    } else {
+        B.tile(x, y, xo, yo, xi, yi, tile_width, tile_width)
+            .parallel(yo)
+            .vectorize(xi, target.natural_vector_size<float>());
+        S.cpu_auto_schedule();
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+Func box_filter(
+        Func input,
+        RecFilterDim x,
+        RecFilterDim y,
+        int radius,
+        int tile_width,
+        Type accum,
+        string name)
+{
+    int width  = x.num_pixels();
+    int height = y.num_pixels();
+
+    // smallest box is at a corner of the image
+    double min_area = double(std::min(radius+1, width)) * std::min(radius+1, height);
+    check_integral_precision(input.output_types()[0], accum, width, height, 1,
+            tile_width, 4.0, min_area, name);
+
+    RecFilter S = integral_image(input, x, y, 1, tile_width, accum, name+"_SAT");
+
+    Var u = x.var();
+    Var v = y.var();
+
+    Func B(name);
+    B(u, v) = cast<float>(box_mean(S, 0, u, v, radius, width, height, accum));
+    B.bound(u, 0, width).bound(v, 0, height);
+
+    // each output tile recomputes the table over the tile plus the box width,
+    // at most four times the work of a single pass while the box fits a tile
+    if (2*radius+1 <= tile_width) {
+        schedule_fused_output(B, S, u, v, tile_width);
+    } else {
+        cerr << "Warning: box of width " << 2*radius+1 << " of " << name << " is "
+            << "wider than a tile, the summed area table is computed at root" << endl;
+        schedule_root_output(B, S, u, v, tile_width);
+    }
+    return B;
+}
+
+// -----------------------------------------------------------------------------
+
+Func guided_filter(
+        Func guide,
+        Func input,
+        RecFilterDim x,
+        RecFilterDim y,
+        int radius,
+        float eps,
+        int tile_width,
+        Type accum,
+        string name)
+{
+    int width  = x.num_pixels();
+    int height = y.num_pixels();
+
+    Var u = x.var();
+    Var v = y.var();
+
+    // box means of I, p, I*p and I*I from one summed area table with four outputs
+    Expr I = cast(accum, guide(u,v));
+    Expr p = cast(accum, input(u,v));
+
+    Func G(name + "_Products");
+    G(u, v) = Tuple(I, p, I*p, I*I);
+
+    RecFilter S = integral_image(G, x, y, 1, tile_width, accum, name+"_SAT");
+
+    Expr mean_I  = box_mean(S, 0, u, v, radius, width, height, accum);
+    Expr mean_p  = box_mean(S, 1, u, v, radius, width, height, accum);
+    Expr mean_Ip = box_mean(S, 2, u, v, radius, width, height, accum);
+    Expr mean_II = box_mean(S, 3, u, v, radius, width, height, accum);
+
+    // linear coefficients are computed in the tiles of the first table, they
+    // are the only intermediate image written to memory
+    Expr a = (mean_Ip - mean_I*mean_p) / (mean_II - mean_I*mean_I + eps);
+    Expr b = mean_p - a*mean_I;
+
+    Func A(name + "_Coeff");
+    A(u, v) = Tuple(cast<float>(a), cast<float>(b));
+    A.bound(u, 0, width).bound(v, 0, height);
+
+    schedule_fused_output(A, S, u, v, tile_width);
+
+    // box means of the coefficients are computed in the tiles of the output
+    RecFilter T = integral_image(A, x, y, 1, tile_width, Float(64), name+"_CoeffSAT");
+
+    Expr mean_a = box_mean(T, 0, u, v, radius, width, height, Float(64));
+    Expr mean_b = box_mean(T, 1, u, v, radius, width, height, Float(64));
+
+    Func Q(name);
+    Q(u, v) = cast<float>(mean_a * cast<double>(guide(u,v)) + mean_b);
+    Q.bound(u, 0, width).bound(v, 0, height);
+
+    schedule_fused_output(Q, T, u, v, tile_width);
+    return Q;
+}
+
+// -----------------------------------------------------------------------------
+
+Func box_gaussian(
+        Func input,
+        RecFilterDim x,
+        RecFilterDim y,
+        float sigma,
+        int iterations,
+        int tile_width,
+        Type accum,
+        string name)
+{
+    int width  = x.num_pixels();
+    int height = y.num_pixels();
+    int k      = iterations;
+
+    // odd box width keeps the cascade centered
+    int box   = gaussian_box_filter(k, sigma);
+    box      += (box%2 ? 0 : 1);
+    int shift = k*(box-1)/2;
+
+    // the stencil reads up to shift pixels beyond the image, pad the integral
+    // image with zeros up to the next multiple of the tile width
+    int padded_width  = (width +shift+tile_width-1) / tile_width * tile_width;
+    int padded_height = (height+shift+tile_width-1) / tile_width * tile_width;
+
+    // stencil weights are products of binomial coefficients summing to 4^k in
+    // absolute value, the result is normalized by box^(2k)
+    check_integral_precision(input.output_types()[0], accum, padded_width,
+            padded_height, k, tile_width, std::pow(4.0, k), std::pow(double(box), 2*k), name);
+
+    Var u = x.var();
+    Var v = y.var();
+
+    Func P(name + "_Pad");
+    P(u, v) = select(u<width && v<height,
+            input(min(u,width-1), min(v,height-1)),
+            make_zero(input.output_types()[0]));
+
+    RecFilter S = integral_image(P,
+            RecFilterDim(u.name(), padded_width),
+            RecFilterDim(v.name(), padded_height),
+            k, tile_width, accum, name+"_SAT");
+
+    // binomial coefficients of (1-z^-box)^k
+    vector<int> c(k+1, 1);
+    for (int i=1; i<=k; i++) {
+        c[i] = -c[i-1] * (k-i+1) / i;
+    }
+
+    Expr sum = make_zero(accum);
+    for (int j=0; j<=k; j++) {
+        for (int i=0; i<=k; i++) {
+            Expr a = u + shift - i*box;
+            Expr b = v + shift - j*box;
+            Expr s = S(max(a,0), max(b,0));
+            sum += cast(accum, c[i]*c[j]) * select(a<0 || b<0, make_zero(accum), s);
+        }
+    }
+
+    Func B(name);
+    B(u, v) = cast<float>(cast<double>(sum) / std::pow(double(box), 2*k));
+    B.bound(u, 0, width).bound(v, 0, height);
+
+    // each tile of the output reads the integral image over the tile plus
+    // the support of the stencil, fusing recomputes this overlap in every
+    // tile which only pays off while the support is small compared to a tile
+    if (k*box <= tile_width) {
+        schedule_fused_output(B, S, u, v, tile_width);
+    } else {
+        cerr << "Warning: support " << k*box << " of " << name << " is wider than "
+            << "a tile, the integral image is computed at root" << endl;
+        schedule_root_output(B, S, u, v, tile_width);
+    }
+    return B;
+}
+
+// -----------------------------------------------------------------------------
+
+vector<RecFilter> gaussian_pyramid(
+        Func input,
+        RecFilterDim x,
+        RecFilterDim y,
+        int levels,
+        float sigma,
+        int order,
+        int tile_width,
+        string name)
+{
+    int width  = x.num_pixels();
+    int height = y.num_pixels();
+
+    if (levels<1 || width % (1<<levels) || height % (1<<levels)) {
+        cerr << "Image size " << width << "x" << height << " of pyramid " << name
+            << " must be a multiple of 2^" << levels << endl;
+        assert(false);
+    }
+
+    vector<float> coeff = gaussian_weights(sigma, order);
+
+    vector<RecFilter> pyramid;
+    Func prev = input;
+
+    for (int i=0; i<levels; i++) {
+        RecFilterDim xl(x.var().name()+std::to_string(i), width >>i);
+        RecFilterDim yl(y.var().name()+std::to_string(i), height>>i);
+
+        // tiles of coarse levels shrink so that every level is tiled, which
+        // is required for strided output
+        int tx = std::min(tile_width, xl.num_pixels()/2);
+        int ty = std::min(tile_width, yl.num_pixels()/2);
+        if (tx%2 || ty%2 || tx<=order || ty<=order ||
+                xl.num_pixels()%tx || yl.num_pixels()%ty) {
+            cerr << "Level " << i << " of pyramid " << name << " cannot be "
+                << "tiled with tile width " << tile_width << endl;
+            assert(false);
+        }
+
+        RecFilter F(name + "_" + std::to_string(i));
+        F.set_clamped_image_border();
+        F(xl, yl) = prev(xl.var(), yl.var());
+        F.add_filter(+xl, coeff);
+        F.add_filter(-xl, coeff);
+        F.add_filter(+yl, coeff);
+        F.add_filter(-yl, coeff);
+        F.set_output_stride(xl, 2);
+        F.set_output_stride(yl, 2);
+        F.split(xl, tx, yl, ty);
+
+        // every level is read whole by the next one, so its decimated output is
+        // computed at root with the scans of each tile computed inside the tile
+        if (F.target().has_gpu_feature()) {
+            F.gpu_auto_schedule();
+        } else {
+            F.cpu_auto_schedule();
+        }
+
+        pyramid.push_back(F);
+        prev = F.as_func();
+    }
+
+    return pyramid;
+}
+
+// -----------------------------------------------------------------------------
+
+/** Recursive filter along the sheared line (mu,1) in the second dimension; the
+ * previous row is read at a fractional offset of mu pixels in the first
+ * dimension by linear interpolation and rows are scanned with clamped border */
+static Func sheared_scan(
+        Func input,
+        int width,
+        int height,
+        vector<float> coeff,
+        float mu,
+        bool causal,
+        Var u,
+        Var v,
+        Target target,
+        string name)
+{
+    int order = coeff.size()-1;
+
+    // row j before along the line is j*mu pixels before in the first dimension
+    auto along_line = [&](Func f, int j, Expr row) {
+        float shift = (causal ? -j*mu : j*mu);
+        int   k     = int(std::floor(shift));
+        float t     = shift - k;
+        Expr a = f(clamp(u+k,   0, width-1), row);
+        Expr b = f(clamp(u+k+1, 0, width-1), row);
+        return (1.0f-t)*a + t*b;
+    };
+
+    // the first row reads the input of the first row in place of all rows
+    // before the image, so it only depends on the input
+    int first = (causal ? 0 : height-1);
+    Expr border = coeff[0] * input(u, first);
+    for (int j=1; j<=order; j++) {
+        border += coeff[j] * along_line(input, j, first);
+    }
+
+    Func F(name);
+    F(u, v) = select(v==first, border, input(u, v));
+
+    if (height > 1) {
+        RDom r(1, height-1, "r" + v.name());
+        Expr row = (causal ? Expr(r) : height-1-r);
+
+        Expr value = coeff[0] * F(u, row);
+        for (int j=1; j<=order; j++) {
+            Expr prev = (causal ? max(row-j, 0) : min(row+j, height-1));
+            value += coeff[j] * along_line(F, j, prev);
+        }
+        F(u, row) = value;
+
+        // each row only reads rows scanned before it, so the pixels of a row
+        // are independent even though they read other columns of the function
+        F.update()
+            .reorder(u, r.x)
+            .allow_race_conditions()
+            .vectorize(u, target.natural_vector_size<float>());
+    }
+    F.compute_root();
+    return F;
+}
+
+Func anisotropic_gaussian(
+        Func input,
+        RecFilterDim x,
+        RecFilterDim y,
+        float sigma_u,
+        float sigma_v,
+        float theta,
+        int order,
+        int tile_width,
+        string name)
+{
+    int width  = x.num_pixels();
+    int height = y.num_pixels();
+
+    // covariance of the rotated Gaussian is the sum of the covariance of a
+    // Gaussian along x and of a Gaussian along the line (mu,1), from which
+    // sigma along x, the shear mu and sigma along the line follow
+    double c   = std::cos(theta);
+    double s   = std::sin(theta);
+    double sxx = sigma_u*sigma_u*c*c + sigma_v*sigma_v*s*s;
+    double syy = sigma_u*sigma_u*s*s + sigma_v*sigma_v*c*c;
+    double sxy = (sigma_u*sigma_u - sigma_v*sigma_v)*c*s;
+
+    float mu      = float(sxy / syy);
+    float sigma_x = float(std::sqrt(std::max(sxx - sxy*sxy/syy, 0.0)));
+    float sigma_t = float(std::sqrt(syy));
+
+    // linear interpolation at fraction t_j of a step of j rows along the line
+    // adds variance t_j(1-t_j) along x; a scan with feedforward b and feedback
+    // a_j takes a_j/b such steps on average, in each direction
+    vector<float> coeff_t = gaussian_weights(sigma_t, order);
+
+    double interp_var = 0.0;
+    for (int j=1; j<coeff_t.size(); j++) {
+        double t = j*double(mu) - std::floor(j*double(mu));
+        interp_var += 2.0 * t*(1.0-t) * coeff_t[j] / coeff_t[0];
+    }
+    sigma_x = float(std::sqrt(std::max(double(sigma_x)*sigma_x - interp_var, 0.0)));
+
+    if (sigma_x < 0.5f || sigma_t < 0.5f) {
+        cerr << "Anisotropic Gaussian " << name << " with sigma " << sigma_u << "x"
+            << sigma_v << " at angle " << theta << " is too narrow along x or "
+            << "along the sheared line" << endl;
+        assert(false);
+    }
+
+    // axis aligned scans as a tiled recursive filter
+    vector<float> coeff_x = gaussian_weights(sigma_x, order);
+
+    RecFilter F(name + "_X");
+    F.set_clamped_image_border();
+    F(x, y) = input(x.var(), y.var());
+    F.add_filter(+x, coeff_x);
+    F.add_filter(-x, coeff_x);
+    F.split(x, tile_width);
+
+    if (F.target().has_gpu_feature()) {
+        F.gpu_auto_schedule();
+    } else {
+        F.cpu_auto_schedule();
+    }
+
+    // scans along the sheared line, interpolated in x
+    Func C = sheared_scan(F.as_func(), width, height, coeff_t, mu, true,
+            x.var(), y.var(), F.target(), name + "_Causal");
+    Func A = sheared_scan(C, width, height, coeff_t, mu, false,
+            x.var(), y.var(), F.target(), name);
+    A.bound(x.var(), 0, width).bound(y.var(), 0, height);
+    return A;
+}
+
+// -----------------------------------------------------------------------------
+
+/** Poles of the B-spline prefilter of given degree */
+static vector<double> bspline_poles(int degree) {
+    if (degree == 3) {
+        return { std::sqrt(3.0)-2.0 };
+    } else if (degree == 5) {
+        return { -0.430575347099973, -0.0430962882032647 };
+    }
+    cerr << "B-spline degree " << degree << " not supported, use 3 or 5" << endl;
+    assert(false);
+    return vector<double>();
+}
+
+/** Centered B-spline basis function of given degree */
+static Expr bspline_basis(int degree, Expr t) {
+    // (1/n!) sum_k (-1)^k C(n+1,k) max(t + (n+1)/2 - k, 0)^n
+    Expr sum = 0.0f;
+    int  binomial = 1;
+    float factorial = 1.0f;
+    for (int k=1; k<=degree; k++) {
+        factorial *= k;
+    }
+    for (int k=0; k<=degree+1; k++) {
+        Expr p = max(t + 0.5f*(degree+1) - k, 0.0f);
+        Expr q = 1.0f;
+        for (int i=0; i<degree; i++) {
+            q = q * p;
+        }
+        sum += float((k%2 ? -1 : 1) * binomial) * q;
+        binomial = binomial * (degree+1-k) / (k+1);
+    }
+    return sum / factorial;
+}
+
+RecFilter bspline_prefilter(
+        Func input,
+        RecFilterDim x,
+        RecFilterDim y,
+        int degree,
+        int tile_width,
+        string name)
+{
+    vector<double> poles = bspline_poles(degree);
+
+    // the scans start in a mirrored margin that is wide enough for the
+    // slowest pole to decay below float precision, which replaces the exact
+    // initialization of the causal and anticausal scans
+    int margin = int(std::ceil(std::log(1e-7) / std::log(std::abs(poles[0]))));
+    while (margin < 4*(x.num_pixels()+y.num_pixels()) &&
+            ((x.num_pixels()+2*margin) % tile_width || (y.num_pixels()+2*margin) % tile_width)) {
+        margin++;
+    }
+    if ((x.num_pixels()+2*margin) % tile_width || (y.num_pixels()+2*margin) % tile_width) {
+        cerr << "Image size " << x.num_pixels() << "x" << y.num_pixels() << " of " << name
+            << " plus a border margin cannot be a multiple of tile width " << tile_width << endl;
+        assert(false);
+    }
+
+    RecFilter S(name);
+    S.set_mirrored_image_border(margin);
+    S(x, y) = cast<float>(input(x.var(), y.var()));
+
+    // each pole z is (1-z)^2 / ((1 - z q^-1)(1 - z q)), which has unit gain
+    RecFilterDim dims[2] = { x, y };
+    for (int d=0; d<2; d++) {
+        for (int i=0; i<poles.size(); i++) {
+            float z = float(poles[i]);
+            S.add_filter(+dims[d], {1.0f-z, z});
+            S.add_filter(-dims[d], {1.0f-z, z});
+        }
+    }
+
+    S.split(x, tile_width, y, tile_width);
+    return S;
+}
+
+Func bspline_warp(
+        Func input,
+        RecFilterDim x,
+        RecFilterDim y,
+        Expr sx,
+        Expr sy,
+        int degree,
+        int tile_width,
+        bool fuse,
+        string name)
+{
+    int width  = x.num_pixels();
+    int height = y.num_pixels();
+
+    RecFilter S = bspline_prefilter(input, x, y, degree, tile_width, name+"_Coeff");
+
+    Var u = x.var();
+    Var v = y.var();
+
+    // coefficients outside the image follow the same mirrored extension as
+    // the prefilter input
+    auto mirror = [&](Expr i, int w) {
+        Expr j = select(i<0, -1-i, select(i>=w, 2*w-1-i, i));
+        return clamp(j, 0, w-1);
+    };
+
+    Expr px = cast<float>(sx);
+    Expr py = cast<float>(sy);
+    Expr ix = cast<int>(floor(px));
+    Expr iy = cast<int>(floor(py));
+    Expr tx = px - cast<float>(ix);
+    Expr ty = py - cast<float>(iy);
+
+    // degree+1 taps from i-(degree-1)/2 to i+(degree+1)/2 in each dimension
+    int first = -(degree-1)/2;
+    int last  =  (degree+1)/2;
+
+    Expr value = 0.0f;
+    for (int dy=first; dy<=last; dy++) {
+        Expr wy = bspline_basis(degree, ty - dy);
+        Expr row = 0.0f;
+        for (int dx=first; dx<=last; dx++) {
+            Expr wx = bspline_basis(degree, tx - dx);
+            row += wx * Expr(S(mirror(ix+dx, width), mirror(iy+dy, height)));
+        }
+        value += wy * row;
+    }
+
+    Func B(name);
+    B(u, v) = value;
+    B.bound(u, 0, width).bound(v, 0, height);
+
+    // a tile reads coefficients within the range of displacements of the
+    // sample positions plus the spline support around the tile, this must be
+    // a constant bounded by a tile to fuse; positions read from other
+    // functions or growing with x or y leave the footprint unbounded
+    if (fuse) {
+        Scope<Interval> scope;
+        scope.push(u.name(), Interval(0, width-1));
+        scope.push(v.name(), Interval(0, height-1));
+
+        bool bounded = true;
+        Expr disp[2] = { simplify(px - cast<float>(u)), simplify(py - cast<float>(v)) };
+        for (int d=0; d<2; d++) {
+            Interval range = bounds_of_expr_in_scope(disp[d], scope);
+            const double* dmin = range.is_bounded() ? as_const_float(simplify(range.min)) : NULL;
+            const double* dmax = range.is_bounded() ? as_const_float(simplify(range.max)) : NULL;
+            bounded &= (dmin && dmax && (*dmax - *dmin) + degree+1 <= tile_width);
+        }
+        if (!bounded) {
+            cerr << "Warning: sample positions of " << name << " are not within a tile "
+                << "of the output pixels, computing " << S.name() << " at root" << endl;
+            fuse = false;
+        }
+    }
+
+    if (fuse) {
+        schedule_fused_output(B, S, u, v, tile_width);
+    } else {
+        schedule_root_output(B, S, u, v, tile_width);
+    }
+    return B;
+}
+
+// -----------------------------------------------------------------------------
+
+RectangleSums::RectangleSums(Type type, int block, int locality) :
+    sat_param(type, 2, "SAT"), rect_param(Int(32), 2, "Rects"), sums("RectSums"),
+    locality(locality)
+{
+    Var i("i");
+
+    Expr w = sat_param.width();
+    Expr h = sat_param.height();
+
+    // inclusive corners, -1 is the zero row before the table
+    Expr x0 = clamp(rect_param(0,i)-1, -1, w-1);
+    Expr y0 = clamp(rect_param(1,i)-1, -1, h-1);
+    Expr x1 = clamp(rect_param(2,i),   -1, w-1);
+    Expr y1 = clamp(rect_param(3,i),   -1, h-1);
+
+    auto sat = [&](Expr a, Expr b) {
+        Expr s = cast<double>(sat_param(max(a,0), max(b,0)));
+        return select(a<0 || b<0, 0.0, s);
+    };
+
+    sums(i) = sat(x1,y1) - sat(x0,y1) - sat(x1,y0) + sat(x0,y0);
+
+    // corners of a vector of queries are gathered in one load each; the
+    // number of queries is arbitrary, so partial blocks and vectors are
+    // guarded instead of shifted inwards, which would read before the first
+    // query when there are fewer queries than a block
+    Target target = get_jit_target_from_environment();
+    Var b("b");
+    sums.split(i, b, i, block, TailStrategy::GuardWithIf)
+        .parallel(b)
+        .vectorize(i, target.natural_vector_size<double>(), TailStrategy::GuardWithIf);
+
+    sums.compile_jit(target);
+}
+
+vector<double> RectangleSums::operator()(Buffer<> sat, const vector<RecFilterRect> &rects) {
+    if (rects.empty()) {
+        return vector<double>();
+    }
+
+    int n = rects.size();
+
+    // sort queries by the cell containing their first corner, row major, so
+    // that queries evaluated together read nearby rows of the table
+    vector<int> order(n);
+    for (int i=0; i<n; i++) {
+        order[i] = i;
+    }
+    int cell = locality;
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        const RecFilterRect& p = rects[a];
+        const RecFilterRect& q = rects[b];
+        if (p.y/cell != q.y/cell) { return p.y/cell < q.y/cell; }
+        if (p.x/cell != q.x/cell) { return p.x/cell < q.x/cell; }
+        return a < b;
+    });
+
+    Buffer<int> corners(4, n);
+    for (int i=0; i<n; i++) {
+        const RecFilterRect& r = rects[order[i]];
+        corners(0,i) = r.x;
+        corners(1,i) = r.y;
+        corners(2,i) = r.x + r.width  - 1;
+        corners(3,i) = r.y + r.height - 1;
+    }
+
+    sat_param .set(sat);
+    rect_param.set(corners);
+    Buffer<double> sorted_sums = sums.realize({n});
+
+    vector<double> result(n);
+    for (int i=0; i<n; i++) {
+        result[order[i]] = sorted_sums(i);
+    }
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+
+/** Semiring sum of two values, i.e. max or min */
+static Expr semiring_add(RecFilterSemiring op, Expr a, Expr b) {
+    return (op==MAX_PLUS ? max(a,b) : min(a,b));
+}
+
+Func semiring_scan(
+        Func input,
+        RecFilterDim x,
+        RecFilterDim y,
+        RecFilterDimAndCausality scan,
+        RecFilterSemiring op,
+        float weight,
+        int tile_width,
+        string name)
+{
+    int d = -1;
+    if (scan.var().name() == x.var().name()) {
+        d = 0;
+    } else if (scan.var().name() == y.var().name()) {
+        d = 1;
+    }
+    int width = (d==0 ? x.num_pixels() : y.num_pixels());
+    if (d<0 || width % tile_width) {
+        cerr << "Scan dimension of " << name << " must be one of the image dimensions "
+            << "and its width must be a multiple of tile width " << tile_width << endl;
+        assert(false);
+    }
+
+    int  num_tiles = width / tile_width;
+    bool causal    = scan.causal();
+    Type type      = input.output_types()[0];
+    Expr w         = cast(type, weight);
+
+    Var u = x.var();
+    Var v = y.var();
+    Var s = (d==0 ? u : v);         // scanned dimension of the output
+    Var o = (d==0 ? v : u);         // other dimension
+    Var xi("xi"), xo("xo");
+
+    // input at position p of the scan, anticausal scans run over the
+    // mirrored position so that all stages below are causal
+    auto in = [&](Expr p) {
+        Expr q = (causal ? p : width-1-p);
+        return (d==0 ? input(q, o) : input(o, q));
+    };
+
+    // scan within each tile
+    RDom ri(1, tile_width-1, "ri");
+    Func intra(name + "_Intra");
+    intra(xi, xo, o) = in(xo*tile_width + xi);
+    intra(ri, xo, o) = semiring_add(op, intra(ri, xo, o), intra(ri-1, xo, o) + w);
+
+    // scan of the last element of each tile across tiles, a whole tile
+    // separates consecutive tails
+    RDom ro(1, std::max(num_tiles-1, 1), "ro");
+    Func tail(name + "_Tail");
+    tail(xo, o) = intra(tile_width-1, xo, o);
+    if (num_tiles > 1) {
+        tail(ro, o) = semiring_add(op, tail(ro, o), tail(ro-1, o) + cast(type, weight*tile_width));
+    }
+
+    // add the tail of the previous tile to each element
+    Expr p  = (causal ? Expr(s) : width-1-s);
+    Expr pi = p % tile_width;
+    Expr po = p / tile_width;
+    Expr carry = tail(max(po-1, 0), o) + cast(type, weight) * cast(type, pi+1);
+
+    Func F(name);
+    F(u, v) = select(po>0, semiring_add(op, intra(pi, po, o), carry), intra(pi, po, o));
+    F.bound(u, 0, x.num_pixels()).bound(v, 0, y.num_pixels());
+
+    // tiles are scanned in parallel and vectorized along the other dimension
+    // when the scan is along the second dimension
+    Target target = get_jit_target_from_environment();
+    int vec = target.natural_vector_size(type);
+
+    intra.compute_root();
+    tail .compute_root();
+    F    .compute_root();
+    if (d == 0) {
+        intra.parallel(o);
+        intra.update().parallel(o);
+        tail .parallel(o);
+        if (num_tiles > 1) {
+            tail.update().parallel(o);
+        }
+        F.parallel(v).vectorize(u, vec);
+    } else {
+        intra.reorder(o, xi, xo).parallel(xo).vectorize(o, vec);
+        intra.update().reorder(o, ri, xo).parallel(xo).vectorize(o, vec);
+        tail .reorder(o, xo).vectorize(o, vec);
+        if (num_tiles > 1) {
+            tail.update().reorder(o, ro).vectorize(o, vec);
+        }
+        F.parallel(v).vectorize(u, vec);
+    }
+
+    return F;
+}
+
+Func distance_transform(
+        Func mask,
+        RecFilterDim x,
+        RecFilterDim y,
+        int tile_width,
+        string name)
+{
+    // L1 distance is separable: causal and anticausal min-plus scans with
+    // unit weight in each dimension starting from 0 on the mask and a large
+    // value elsewhere
+    float far = float(x.num_pixels() + y.num_pixels());
+
+    Func D(name + "_Init");
+    D(x.var(), y.var()) = select(mask(x.var(), y.var()) != 0, 0.0f, far);
+
+    D = semiring_scan(D, x, y, +x, MIN_PLUS, 1.0f, tile_width, name+"_X0");
+    D = semiring_scan(D, x, y, -x, MIN_PLUS, 1.0f, tile_width, name+"_X1");
+    D = semiring_scan(D, x, y, +y, MIN_PLUS, 1.0f, tile_width, name+"_Y0");
+    D = semiring_scan(D, x, y, -y, MIN_PLUS, 1.0f, tile_width, name+"_Y1");
+    return D;
+}
@@ -0,0 +1,366 @@
+#ifndef _RECURSIVE_FILTER_BUILDERS_H_
+#define _RECURSIVE_FILTER_BUILDERS_H_
+
+#include <vector>
+#include <string>
+#include <Halide.h>
+
+#include "recfilter.h"
+
+/**
+ * @brief Gaussian pyramid as a chain of tiled recursive filters
+ *
+ * Each level blurs the previous level with causal and anticausal recursive
+ * Gaussian approximations in both dimensions and stores every second pixel;
+ * the next level consumes the decimated output directly, so no full resolution
+ * blurred image is written to memory. Each level is scheduled with
+ * RecFilter::cpu_auto_schedule() or RecFilter::gpu_auto_schedule() for its
+ * target: the decimated output of a level is computed at root and the full
+ * resolution result of each tile stays local to the tile.
+ *
+ * @param[in] input single channel floating point input image
+ * @param[in] x first dimension of the finest level, width must be a multiple of 2^levels
+ * @param[in] y second dimension of the finest level, width must be a multiple of 2^levels
+ * @param[in] levels number of decimated levels
+ * @param[in] sigma sigma of the Gaussian blur applied before each decimation
+ * @param[in] order order of the recursive Gaussian approximation (1, 2 or 3)
+ * @param[in] tile_width tile width, reduced for coarse levels narrower than two tiles
+ * @param[in] name prefix of the names of the filters, level i is named name_i
+ * @return one filter per level, level i produces an image 2^(i+1) times smaller than the input
+ */
+std::vector<RecFilter> gaussian_pyramid(
+        Halide::Func input,
+        RecFilterDim x,
+        RecFilterDim y,
+        int levels,
+        float sigma,
+        int order,
+        int tile_width,
+        std::string name="Pyramid");
+
+/**
+ * @brief Box filter of arbitrary radius from a tiled summed area table
+ *
+ * The summed area table is a tiled recursive filter whose final result is
+ * computed inside each tile of the returned function, which applies the 4-tap
+ * difference stencil directly; the summed area table is never written to a
+ * global buffer. Tiles of the summed area table overlapping the box of border
+ * pixels of an output tile are recomputed, at most four times the work of a
+ * single pass; boxes wider than a tile compute the table once at root instead,
+ * with a warning. Boxes are clipped at the image border and normalized by the
+ * number of pixels inside the image.
+ *
+ * Tiling does not bound the magnitude of the table: it holds sums from the
+ * origin of the image, and box sums are differences of such large values.
+ * The builder therefore checks the precision of the configuration and fails
+ * otherwise: integer images must fit the exact range of the accumulation
+ * type, and for floating point images the worst case rounding error of the
+ * table relative to the largest input must stay below the resolution of the
+ * Float(32) result, which rules out Float(32) accumulation and very large
+ * images with small boxes.
+ *
+ * @param[in] input single channel input image
+ * @param[in] x first dimension of the image, width must be a multiple of tile width
+ * @param[in] y second dimension of the image, width must be a multiple of tile width
+ * @param[in] radius box radius, the box width is 2*radius+1
+ * @param[in] tile_width tile width of the summed area table and the output
+ * @param[in] accum accumulation type of the summed area table, Float(64), or
+ * Int(64) for integer images; see above for the precision check
+ * @param[in] name name of the returned function, the summed area table is name_SAT
+ * @return scheduled function computing the box filtered image as Float(32)
+ */
+Halide::Func box_filter(
+        Halide::Func input,
+        RecFilterDim x,
+        RecFilterDim y,
+        int radius,
+        int tile_width,
+        Halide::Type accum=Halide::Float(64),
+        std::string name="Box");
+
+/**
+ * @brief Guided filter from two fused summed area table passes
+ *
+ * The box means of I, p, I*p and I*I are read from one tiled summed area table
+ * with four outputs, whose final result is computed inside the tiles of the
+ * function computing the linear coefficients a and b; the box means of a and b
+ * are read from a second two-output table computed inside the tiles of the
+ * returned function. The coefficients are the only intermediate image written
+ * to memory. Boxes are clipped at the image border.
+ *
+ * @param[in] guide single channel guidance image I
+ * @param[in] input single channel image p to be filtered
+ * @param[in] x first dimension of the image, width must be a multiple of tile width
+ * @param[in] y second dimension of the image, width must be a multiple of tile width
+ * @param[in] radius box radius, the box width is 2*radius+1
+ * @param[in] eps regularization of the linear coefficients
+ * @param[in] tile_width tile width of the summed area tables and the output
+ * @param[in] accum accumulation type of the first summed area table, Int(64) is
+ * exact for integer images, the table of the coefficients is Float(64)
+ * @param[in] name name of the returned function
+ * @return scheduled function computing the filtered image as Float(32)
+ */
+Halide::Func guided_filter(
+        Halide::Func guide,
+        Halide::Func input,
+        RecFilterDim x,
+        RecFilterDim y,
+        int radius,
+        float eps,
+        int tile_width,
+        Halide::Type accum=Halide::Float(64),
+        std::string name="Guided");
+
+/**
+ * @brief Gaussian blur approximated by repeated box filters in a single pass
+ *
+ * Applying a box filter of width w k times is equivalent to computing the k-th
+ * order integral image followed by a separable binomial stencil with (k+1)^2
+ * taps spaced w apart; w is given by gaussian_box_filter(). The integral image is
+ * a single tiled recursive filter over the image padded with zeros by the
+ * support of the stencil. While the support k*w is at most the tile width, the
+ * final result of the integral image is computed inside each tile of the
+ * returned function; each tile then recomputes it over (tile width + k*w)^2
+ * pixels, so the cost per pixel grows with sigma. Wider stencils compute the
+ * integral image once at root, which writes it to memory but makes the cost
+ * per pixel independent of sigma; a warning is printed in this case. Pixels
+ * outside the image are zero.
+ *
+ * The k-th integral grows as the k-th power of the image area, so the builder
+ * fails unless the configuration keeps the result precise: for integer
+ * images the largest stencil sum must fit below 2^63 for Int(64) or 2^53 for
+ * Float(64), and for floating point images the worst case rounding error
+ * relative to the largest input must stay below the resolution of Float(32).
+ * Large images and k of 3 or more typically require integer images with
+ * Int(64) accumulation, and k=4 overflows it beyond small images.
+ *
+ * @param[in] input single channel input image
+ * @param[in] x first dimension of the image
+ * @param[in] y second dimension of the image
+ * @param[in] sigma sigma of the approximated Gaussian
+ * @param[in] iterations number of repeated box filters k
+ * @param[in] tile_width tile width of the integral image and the output
+ * @param[in] accum accumulation type of the integral image; Int(64) or
+ * Float(64), see above for the range check; integer types require an integer
+ * image
+ * @param[in] name name of the returned function, the integral image is name_SAT
+ * @return scheduled function computing the blurred image as Float(32)
+ */
+Halide::Func box_gaussian(
+        Halide::Func input,
+        RecFilterDim x,
+        RecFilterDim y,
+        float sigma,
+        int iterations,
+        int tile_width,
+        Halide::Type accum=Halide::Float(64),
+        std::string name="BoxGaussian");
+
+/**
+ * @brief Oriented anisotropic Gaussian from axis aligned and sheared scans
+ *
+ * Decomposition of Geusebroek, Smeulders and van de Weijer, "Fast anisotropic
+ * Gauss filtering", IEEE Trans. on Image Processing 2003: a Gaussian with
+ * sigma_u along the direction theta and sigma_v across it is a Gaussian along
+ * x followed by a Gaussian along the sheared line (mu,1). The first is a tiled
+ * recursive filter with causal and anticausal scans; the second scans rows,
+ * reading previous rows j*mu pixels away by linear interpolation, so the image
+ * is never rotated or resampled. Borders are clamped.
+ *
+ * Linear interpolation at a fraction t of a pixel blurs along x with variance
+ * t(1-t) at every step along the line. The expected number of steps follows
+ * from the scan coefficients, and the added variance is subtracted from the
+ * variance of the Gaussian along x. The correction is exact for the second
+ * moment away from the borders; higher moments keep a small bias, largest
+ * when j*mu is close to a half integer. Both passes use the target of the
+ * scans along x.
+ *
+ * @param[in] input single channel floating point input image
+ * @param[in] x first dimension of the image, width must be a multiple of tile width
+ * @param[in] y second dimension of the image
+ * @param[in] sigma_u sigma along the direction theta
+ * @param[in] sigma_v sigma across the direction theta
+ * @param[in] theta angle of the direction of sigma_u with the x axis in radians
+ * @param[in] order order of the recursive Gaussian approximation (1, 2 or 3)
+ * @param[in] tile_width tile width of the scans along x
+ * @param[in] name name of the returned function, the scans along x are name_X
+ * @return scheduled function computing the blurred image as Float(32)
+ */
+Halide::Func anisotropic_gaussian(
+        Halide::Func input,
+        RecFilterDim x,
+        RecFilterDim y,
+        float sigma_u,
+        float sigma_v,
+        float theta,
+        int order,
+        int tile_width,
+        std::string name="Anisotropic");
+
+/**
+ * @brief Recursive B-spline prefilter as a tiled recursive filter
+ *
+ * Computes the B-spline coefficients of an image by a causal and an anticausal
+ * scan for each pole in each dimension, e.g. the single pole sqrt(3)-2 for cubic
+ * splines, with unit gain folded into the feedforward coeffs. The image is
+ * extended by mirroring over a margin in which the slowest pole decays below
+ * float precision, which replaces the exact initialization of the scans; the
+ * margin is increased until image width plus twice the margin is a multiple of
+ * the tile width.
+ *
+ * @param[in] input single channel input image
+ * @param[in] x first dimension of the image
+ * @param[in] y second dimension of the image
+ * @param[in] degree B-spline degree, 3 or 5
+ * @param[in] tile_width tile width of the filter
+ * @param[in] name name of the filter
+ * @return tiled filter computing the coefficients as Float(32), to be scheduled
+ * by the caller for its target
+ */
+RecFilter bspline_prefilter(
+        Halide::Func input,
+        RecFilterDim x,
+        RecFilterDim y,
+        int degree,
+        int tile_width,
+        std::string name="BSpline");
+
+/**
+ * @brief B-spline interpolation of an image at arbitrary sample positions
+ *
+ * Prefilters the image with bspline_prefilter() and evaluates the spline at the
+ * given positions from (degree+1)^2 coefficients. If fused, the coefficients are
+ * computed inside each tile of the output and never stored; this pays off when
+ * Halide can bound the positions read by a tile, e.g. for small displacements,
+ * otherwise tiles recompute large parts of the coefficient image. Fusion
+ * therefore requires that the range of the displacements sx-x and sy-y over
+ * the image plus degree+1 is at most the tile width; other positions, e.g.
+ * read from a flow field, print a warning and compute the coefficients once
+ * at root. Both functions are scheduled for the target of the prefilter.
+ *
+ * @param[in] input single channel input image
+ * @param[in] x first dimension of the image and the output
+ * @param[in] y second dimension of the image and the output
+ * @param[in] sx sample position in the first dimension as a function of x and y
+ * @param[in] sy sample position in the second dimension as a function of x and y
+ * @param[in] degree B-spline degree, 3 or 5
+ * @param[in] tile_width tile width of the prefilter and the output
+ * @param[in] fuse compute the prefilter inside the tiles of the output
+ * @param[in] name name of the returned function, the prefilter is name_Coeff
+ * @return scheduled function computing the interpolated image as Float(32)
+ */
+Halide::Func bspline_warp(
+        Halide::Func input,
+        RecFilterDim x,
+        RecFilterDim y,
+        Halide::Expr sx,
+        Halide::Expr sy,
+        int degree,
+        int tile_width,
+        bool fuse=false,
+        std::string name="Warp");
+
+// ----------------------------------------------------------------------------
+
+/** Axis aligned rectangle for summed area table queries */
+struct RecFilterRect {
+    int x;          ///< first column of the rectangle
+    int y;          ///< first row of the rectangle
+    int width;      ///< number of columns
+    int height;     ///< number of rows
+};
+
+/**
+ * @brief Batched rectangle sums over a summed area table
+ *
+ * Evaluates the sums of many rectangles, e.g. Haar-like features, from a summed
+ * area table realized by a recursive filter such as one with integral_image_coeff(1)
+ * scans in both dimensions. Queries are sorted so that consecutive queries read
+ * nearby parts of the table, then evaluated by a JIT compiled pipeline that
+ * gathers the four corners of a vector of queries at once and runs blocks of
+ * queries in parallel. The pipeline is compiled once on construction.
+ *
+ * Queries cannot be fused into the tiles of the summed area table because the
+ * tiles they read are only known at run time, so the table must be realized first.
+ */
+class RectangleSums {
+public:
+    /** Compile the query pipeline
+     * \param type element type of the summed area table
+     * \param block number of queries evaluated by each parallel task
+     * \param locality size of the cells by which queries are sorted
+     */
+    RectangleSums(Halide::Type type, int block=4096, int locality=64);
+
+    /** Sum of each rectangle, rectangles are clipped to the table
+     * \param sat summed area table, e.g. the first buffer of RecFilter::realize()
+     * \param rects list of rectangles
+     * \returns sum of each rectangle in the order of the given list
+     */
+    std::vector<double> operator()(Halide::Buffer<> sat, const std::vector<RecFilterRect> &rects);
+
+private:
+    Halide::ImageParam sat_param;   ///< summed area table
+    Halide::ImageParam rect_param;  ///< corners of sorted queries: x0, y0, x1, y1
+    Halide::Func       sums;        ///< sum of each sorted query
+    int                locality;    ///< size of the cells by which queries are sorted
+};
+
+// ----------------------------------------------------------------------------
+
+/** Semirings for scans y[n] = y[n-1]*w + x[n] where * and + are replaced by + and max or min */
+enum RecFilterSemiring {
+    MAX_PLUS,       ///< y[n] = max(x[n], y[n-1]+w), e.g. dilation by a cone
+    MIN_PLUS,       ///< y[n] = min(x[n], y[n-1]+w), e.g. chamfer distance transforms
+};
+
+/**
+ * @brief Tiled first order scan in the max-plus or min-plus semiring
+ *
+ * The tiled algorithm of linear scans carries over to any semiring: each tile
+ * is scanned independently, the last element of each tile is scanned across
+ * tiles with weight w*tile_width, and each element of a tile is combined with
+ * the tail of the previous tile plus w times its distance to the tile border.
+ * Tiles are scanned in parallel and the last stage is fused with the output.
+ * The linear tiling of RecFilter::split() relies on multiplication by tail
+ * weights, so these scans are built as separate functions.
+ *
+ * @param[in] input single channel input image
+ * @param[in] x first dimension of the image
+ * @param[in] y second dimension of the image
+ * @param[in] scan scan dimension and causality, one of +x, -x, +y or -y
+ * @param[in] op semiring
+ * @param[in] weight weight w added per pixel of distance
+ * @param[in] tile_width tile width along the scan, must divide the image width
+ * @param[in] name name of the returned function
+ * @return scheduled function computing the scan in the type of the input
+ */
+Halide::Func semiring_scan(
+        Halide::Func input,
+        RecFilterDim x,
+        RecFilterDim y,
+        RecFilterDimAndCausality scan,
+        RecFilterSemiring op,
+        float weight,
+        int tile_width,
+        std::string name="Scan");
+
+/**
+ * @brief L1 distance transform as four tiled min-plus scans
+ *
+ * @param[in] mask single channel image, non-zero pixels are at distance 0
+ * @param[in] x first dimension of the image, width must be a multiple of tile width
+ * @param[in] y second dimension of the image, width must be a multiple of tile width
+ * @param[in] tile_width tile width of all scans
+ * @param[in] name prefix of the names of the scans
+ * @return scheduled function computing the L1 distance to the nearest
+ * non-zero pixel of the mask as Float(32)
+ */
+Halide::Func distance_transform(
+        Halide::Func mask,
+        RecFilterDim x,
+        RecFilterDim y,
+        int tile_width,
+        std::string name="Distance");
+
+#endif // _RECURSIVE_FILTER_BUILDERS_H_
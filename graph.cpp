@@ -0,0 +1,219 @@
+#include "recfilter.h"
+#include "recfilter_internals.h"
+#include "modifiers.h"
+
+using std::string;
+using std::cerr;
+using std::endl;
+using std::vector;
+using std::map;
+using std::stringstream;
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+// -----------------------------------------------------------------------------
+
+// Count arithmetic operations in an expression
+class CountArithmeticOps : public IRVisitor {
+private:
+    using IRVisitor::visit;
+    void visit(const Add    *op) { count++; IRVisitor::visit(op); }
+    void visit(const Sub    *op) { count++; IRVisitor::visit(op); }
+    void visit(const Mul    *op) { count++; IRVisitor::visit(op); }
+    void visit(const Div    *op) { count++; IRVisitor::visit(op); }
+    void visit(const Min    *op) { count++; IRVisitor::visit(op); }
+    void visit(const Max    *op) { count++; IRVisitor::visit(op); }
+    void visit(const Select *op) { count++; IRVisitor::visit(op); }
+
+    // integer index arithmetic in calling args is not counted
+    void visit(const Call *op) {}
+
+public:
+    int count;
+    CountArithmeticOps(void) : count(0) {}
+};
+
+/** Node of the function dependency graph */
+struct GraphNode {
+    string  name;           ///< function name
+    string  func_tag;       ///< function tag
+    string  compute_level;  ///< inline, root or loop level
+    int64_t storage_bytes;  ///< estimated buffer size, -1 if unknown
+    int64_t flops;          ///< estimated arithmetic operations, -1 if unknown
+    double  time_ms;        ///< measured time from the last traced realization, -1 if unavailable
+};
+
+/** Edge from producer to consumer of the function dependency graph */
+struct GraphEdge {
+    string  producer;       ///< name of producer function
+    string  consumer;       ///< name of consumer function
+    int64_t bytes;          ///< estimated bytes read by the consumer, -1 if unknown
+};
+
+// -----------------------------------------------------------------------------
+
+/** Build the dependency graph of a finalized filter from its loop nests */
+static void build_graph(
+        RecFilterContents *ptr,
+        vector<RecFilterLoopNest> loop_nests,
+        vector<GraphNode> &nodes,
+        vector<GraphEdge> &edges)
+{
+    // measured time of each function from the production events of the last trace
+    map<string,double> time_ms;
+    ProfilingInfo& p = ptr->profiling;
+    if (p.tracing) {
+        std::list<TraceBuffer>::const_iterator b;
+        for (b=p.trace_buffers.begin(); b!=p.trace_buffers.end(); b++) {
+            uint64_t capacity = b->events.size();
+            uint64_t start    = (b->count > capacity ? b->count-capacity : 0);
+            for (uint64_t i=start; i<b->count; i++) {
+                const TraceEvent& ev = b->events[i % capacity];
+                if (ev.stage>=0 && ev.task<0) {
+                    time_ms[p.stage_name[ev.stage]] += (ev.end-ev.begin)/1e6;
+                }
+            }
+        }
+    }
+
+    map<string,RecFilterFunc>::iterator fit;
+    for (fit=ptr->func.begin(); fit!=ptr->func.end(); fit++) {
+        Function f = fit->second.func;
+
+        GraphNode node;
+        node.name          = f.name();
+        node.storage_bytes = -1;
+        node.flops         = 0;
+        node.time_ms       = (time_ms.count(f.name()) ? time_ms[f.name()] : -1.0);
+
+        // flops of each definition is the op count per point times the
+        // number of iterations of its loop nest
+        for (int i=0; i<loop_nests.size(); i++) {
+            RecFilterLoopNest& n = loop_nests[i];
+            if (n.name != f.name()) {
+                continue;
+            }
+            node.func_tag      = n.func_tag;
+            node.compute_level = n.compute_level;
+            node.storage_bytes = n.storage_bytes;
+
+            Definition def = (n.definition<0 ? f.definition() : f.update(n.definition));
+            CountArithmeticOps ops;
+            for (int j=0; j<def.values().size(); j++) {
+                def.values()[j].accept(&ops);
+            }
+
+            int64_t iterations = 1;
+            for (int j=0; j<n.loops.size(); j++) {
+                iterations *= n.loops[j].extent;
+            }
+            if (iterations<=0 || node.flops<0) {
+                node.flops = -1;
+            } else {
+                node.flops += ops.count * iterations;
+            }
+        }
+        nodes.push_back(node);
+    }
+
+    // an edge for every pair of functions where one calls the other
+    for (int i=0; i<nodes.size(); i++) {
+        for (int j=0; j<nodes.size(); j++) {
+            if (i == j) {
+                continue;
+            }
+            Function consumer = ptr->func[nodes[j].name].func;
+
+            bool calls = false;
+            for (int d=-1; !calls && d<int(consumer.updates().size()); d++) {
+                Definition def = (d<0 ? consumer.definition() : consumer.update(d));
+                for (int k=0; !calls && k<def.values().size(); k++) {
+                    calls |= expr_depends_on_func(def.values()[k], nodes[i].name);
+                }
+            }
+
+            if (calls) {
+                // inlined producers are recomputed in registers, others are
+                // read from memory at least once
+                GraphEdge e;
+                e.producer = nodes[i].name;
+                e.consumer = nodes[j].name;
+                e.bytes    = (nodes[i].compute_level=="inline" ? 0 : nodes[i].storage_bytes);
+                edges.push_back(e);
+            }
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+string RecFilter::print_graph_dot(void) {
+    auto ptr = contents.get();
+
+    vector<GraphNode> nodes;
+    vector<GraphEdge> edges;
+    build_graph(ptr, loop_report(), nodes, edges);
+
+    stringstream s;
+    s << "digraph \"" << ptr->name << "\" {\n";
+    s << "    rankdir=LR;\n";
+    s << "    node [shape=record, fontname=\"monospace\"];\n";
+    for (int i=0; i<nodes.size(); i++) {
+        GraphNode& n = nodes[i];
+        s << "    \"" << n.name << "\" [label=\"{" << n.name
+          << "|" << n.func_tag << ", " << n.compute_level;
+        if (n.storage_bytes >= 0) {
+            s << "|" << n.storage_bytes << " bytes";
+        }
+        if (n.flops >= 0) {
+            s << "|" << n.flops << " flops";
+        }
+        if (n.time_ms >= 0) {
+            s << "|" << n.time_ms << " ms";
+        }
+        s << "}\"";
+        if (n.compute_level == "root") {
+            s << ", style=bold";
+        }
+        s << "];\n";
+    }
+    for (int i=0; i<edges.size(); i++) {
+        s << "    \"" << edges[i].producer << "\" -> \"" << edges[i].consumer << "\"";
+        if (edges[i].bytes > 0) {
+            s << " [label=\"" << edges[i].bytes << " B\"]";
+        }
+        s << ";\n";
+    }
+    s << "}\n";
+    return s.str();
+}
+
+string RecFilter::print_graph_json(void) {
+    auto ptr = contents.get();
+
+    vector<GraphNode> nodes;
+    vector<GraphEdge> edges;
+    build_graph(ptr, loop_report(), nodes, edges);
+
+    stringstream s;
+    s << "{\n  \"name\": \"" << ptr->name << "\",\n  \"nodes\": [\n";
+    for (int i=0; i<nodes.size(); i++) {
+        GraphNode& n = nodes[i];
+        s << "    {\"name\": \"" << n.name << "\", \"func_tag\": \"" << n.func_tag
+          << "\", \"compute_level\": \"" << n.compute_level
+          << "\", \"storage_bytes\": " << n.storage_bytes
+          << ", \"flops\": " << n.flops
+          << ", \"time_ms\": " << n.time_ms << "}"
+          << (i+1<nodes.size() ? ",\n" : "\n");
+    }
+    s << "  ],\n  \"edges\": [\n";
+    for (int i=0; i<edges.size(); i++) {
+        s << "    {\"producer\": \"" << edges[i].producer
+          << "\", \"consumer\": \"" << edges[i].consumer
+          << "\", \"bytes\": " << edges[i].bytes << "}"
+          << (i+1<edges.size() ? ",\n" : "\n");
+    }
+    s << "  ]\n}\n";
+    return s.str();
+}
@@ -3,6 +3,8 @@
 using namespace Halide;
 
 using std::vector;
+using std::cerr;
+using std::endl;
 
 /** Compute the factorial of an integer */
 static inline int factorial(int k) {
@@ -261,3 +263,247 @@ vector<float> overlap_feedback_coeff(vector<float> a, vector<float> b) {
 
     return c;
 }
+
+// -----------------------------------------------------------------------------
+
+/** Check stability of feedback coeff by the step-down recursion: all reflection
+ * coeff of 1 - sum_j feedback[j] z^-(j+1) must lie inside the unit circle */
+static bool stable_feedback(const vector<double> &feedback) {
+    int p = feedback.size();
+    vector<double> a(p+1);
+    a[0] = 1.0;
+    for (int i=1; i<=p; i++) {
+        a[i] = -feedback[i-1];
+    }
+    for (int m=p; m>=1; m--) {
+        double k = a[m];
+        if (std::abs(k) >= 1.0) {
+            return false;
+        }
+        vector<double> b(m);
+        b[0] = 1.0;
+        for (int i=1; i<m; i++) {
+            b[i] = (a[i] - k*a[m-i]) / (1.0-k*k);
+        }
+        a = b;
+    }
+    return true;
+}
+
+/** Impulse response of a causal scan followed by an anticausal scan with the
+ * same coeff, sampled at offsets -m..m from the impulse */
+static vector<double> causal_anticausal_response(
+        double feedfwd,
+        const vector<double> &feedback,
+        int m)
+{
+    // simulate on a domain large enough that the truncated tails are negligible
+    // compared to the part of the response that is compared with the kernel
+    int n = 4*(2*m+1);
+    int c = n/2;
+    int p = feedback.size();
+
+    vector<double> y(n, 0.0);
+    y[c] = 1.0;
+    for (int i=0; i<n; i++) {
+        double v = feedfwd * y[i];
+        for (int j=0; j<p && i-j-1>=0; j++) {
+            v += feedback[j] * y[i-j-1];
+        }
+        y[i] = v;
+    }
+    for (int i=n-1; i>=0; i--) {
+        double v = feedfwd * y[i];
+        for (int j=0; j<p && i+j+1<n; j++) {
+            v += feedback[j] * y[i+j+1];
+        }
+        y[i] = v;
+    }
+
+    return vector<double>(y.begin()+c-m, y.begin()+c+m+1);
+}
+
+/** Squared error between the response of the coeff and the target kernel;
+ * the kernel is compared on twice its support so that slowly decaying
+ * responses are penalized */
+static double fit_error(
+        double feedfwd,
+        const vector<double> &feedback,
+        const vector<double> &kernel,
+        vector<double> &residual)
+{
+    int m = kernel.size();      // compared on -m..m, kernel has support -m/2..m/2
+    vector<double> h = causal_anticausal_response(feedfwd, feedback, m);
+
+    residual = vector<double>(2*m+1);
+    double e = 0.0;
+    for (int i=0; i<2*m+1; i++) {
+        int k = i - m + int(kernel.size())/2;
+        double target = (k>=0 && k<kernel.size() ? kernel[k] : 0.0);
+        residual[i] = h[i] - target;
+        e += residual[i]*residual[i];
+    }
+    return e;
+}
+
+vector<float> fit_recursive_filter(vector<float> kernel, int order, float &error) {
+    int m = kernel.size()/2;
+
+    if (kernel.size()%2==0 || order<1 || order>m) {
+        cerr << "Cannot fit recursive filter of order " << order << " to kernel of "
+            << kernel.size() << " taps; kernel must have odd size larger than twice the order" << endl;
+        assert(false);
+    }
+
+    vector<double> h(kernel.size());
+    double norm = 0.0;
+    for (int i=0; i<kernel.size(); i++) {
+        h[i]  = 0.5 * (kernel[i] + kernel[kernel.size()-1-i]);
+        norm += h[i]*h[i];
+    }
+
+    // initial estimate: b^2/(A(z)A(1/z)) is the spectrum of an autoregressive
+    // process, so the symmetric kernel is its autocorrelation and the
+    // Yule-Walker equations solved by Levinson-Durbin recursion give A and b
+    vector<double> r(order+1);
+    for (int i=0; i<=order; i++) {
+        r[i] = h[m+i];
+    }
+    vector<double> a(order+1, 0.0);   // prediction coeff, a[0] unused
+    double prediction_error = r[0];
+    for (int i=1; i<=order && prediction_error>0.0; i++) {
+        double acc = r[i];
+        for (int j=1; j<i; j++) {
+            acc -= a[j] * r[i-j];
+        }
+        double k = acc / prediction_error;
+        vector<double> prev = a;
+        a[i] = k;
+        for (int j=1; j<i; j++) {
+            a[j] = prev[j] - k*prev[i-j];
+        }
+        prediction_error *= (1.0 - k*k);
+    }
+
+    double feedfwd = std::sqrt(std::max(prediction_error, 0.0));
+    vector<double> feedback(a.begin()+1, a.end());
+
+    // the kernel may not have a positive spectrum, start from a stable guess
+    if (!(feedfwd>0.0) || !stable_feedback(feedback)) {
+        feedback = vector<double>(order, 0.0);
+        feedfwd  = std::sqrt(std::max(r[0], 1e-12));
+    }
+
+    // refine by Levenberg-Marquardt iterations on the squared error of the
+    // impulse response, rejecting steps that make the filter unstable
+    int num_params = order+1;
+    vector<double> residual;
+    double e = fit_error(feedfwd, feedback, h, residual);
+    double lambda = 1e-3;
+
+    for (int iter=0; iter<100; iter++) {
+        // numerical Jacobian of the residual with respect to all coeff
+        vector<double> params(num_params);
+        params[0] = feedfwd;
+        for (int i=0; i<order; i++) {
+            params[i+1] = feedback[i];
+        }
+
+        vector<vector<double> > J(num_params);
+        for (int i=0; i<num_params; i++) {
+            vector<double> p = params;
+            double delta = 1e-6 * std::max(1.0, std::abs(p[i]));
+            p[i] += delta;
+            vector<double> fb(p.begin()+1, p.end());
+            vector<double> rp;
+            fit_error(p[0], fb, h, rp);
+            J[i] = vector<double>(rp.size());
+            for (int k=0; k<rp.size(); k++) {
+                J[i][k] = (rp[k]-residual[k]) / delta;
+            }
+        }
+
+        // normal equations (J^T J + lambda diag) step = -J^T r
+        vector<vector<double> > M(num_params, vector<double>(num_params+1, 0.0));
+        for (int i=0; i<num_params; i++) {
+            for (int j=0; j<num_params; j++) {
+                for (int k=0; k<residual.size(); k++) {
+                    M[i][j] += J[i][k]*J[j][k];
+                }
+            }
+            M[i][i] *= (1.0 + lambda);
+            for (int k=0; k<residual.size(); k++) {
+                M[i][num_params] -= J[i][k]*residual[k];
+            }
+        }
+
+        // Gaussian elimination with partial pivoting
+        bool singular = false;
+        for (int i=0; i<num_params && !singular; i++) {
+            int pivot = i;
+            for (int j=i+1; j<num_params; j++) {
+                if (std::abs(M[j][i]) > std::abs(M[pivot][i])) {
+                    pivot = j;
+                }
+            }
+            std::swap(M[i], M[pivot]);
+            if (std::abs(M[i][i]) < 1e-300) {
+                singular = true;
+                break;
+            }
+            for (int j=i+1; j<num_params; j++) {
+                double f = M[j][i] / M[i][i];
+                for (int k=i; k<=num_params; k++) {
+                    M[j][k] -= f*M[i][k];
+                }
+            }
+        }
+        if (singular) {
+            break;
+        }
+        vector<double> step(num_params);
+        for (int i=num_params-1; i>=0; i--) {
+            double v = M[i][num_params];
+            for (int j=i+1; j<num_params; j++) {
+                v -= M[i][j]*step[j];
+            }
+            step[i] = v / M[i][i];
+        }
+
+        double new_feedfwd = feedfwd + step[0];
+        vector<double> new_feedback(order);
+        for (int i=0; i<order; i++) {
+            new_feedback[i] = feedback[i] + step[i+1];
+        }
+
+        vector<double> new_residual;
+        double new_e = (stable_feedback(new_feedback) ?
+                fit_error(new_feedfwd, new_feedback, h, new_residual) : e+1.0);
+
+        if (new_e < e) {
+            bool converged = (e-new_e < 1e-12*e);
+            feedfwd  = new_feedfwd;
+            feedback = new_feedback;
+            residual = new_residual;
+            e        = new_e;
+            lambda   = std::max(lambda*0.3, 1e-12);
+            if (converged) {
+                break;
+            }
+        } else {
+            lambda *= 10.0;
+            if (lambda > 1e12) {
+                break;
+            }
+        }
+    }
+
+    error = float(std::sqrt(e / std::max(norm, 1e-300)));
+
+    vector<float> coeff;
+    coeff.push_back(float(feedfwd));
+    for (int i=0; i<order; i++) {
+        coeff.push_back(float(feedback[i]));
+    }
+    return coeff;
+}
@@ -70,6 +70,27 @@ std::vector<float> gaussian_weights(float sigma, int order);
 int gaussian_box_filter(int iterations, float sigma);
 
 
+/**
+ * @brief Fit a causal and anticausal pair of recursive filters to a symmetric kernel
+ *
+ * Finds coeff such that applying a causal scan followed by an anticausal scan
+ * with the same coeff approximates convolution with the kernel. The initial
+ * estimate treats the kernel as the autocorrelation of an autoregressive process
+ * and solves the Yule-Walker equations by Levinson-Durbin recursion; it is then
+ * refined by Levenberg-Marquardt iterations on the squared error of the impulse
+ * response, keeping the filter stable. Replaces convolution with a kernel of
+ * many taps by two scans of the given order.
+ *
+ * @param[in] kernel symmetric kernel of odd size, centered at kernel.size()/2
+ * @param[in] order order of each recursive filter
+ * @param[out] error relative L2 error of the impulse response of the fitted
+ * filter pair compared with the kernel over twice its support
+ * @return vector with feedforward coeff as first element and rest feedback
+ * coeff, to be used with add_filter(+x, coeff) and add_filter(-x, coeff)
+ */
+std::vector<float> fit_recursive_filter(std::vector<float> kernel, int order, float &error);
+
+
 /** @brief Apply Gaussian filter on an input image
  *
  * @param[in] in input single channel image
@@ -0,0 +1,249 @@
+#include "recfilter.h"
+#include "recfilter_internals.h"
+
+using std::string;
+using std::cerr;
+using std::endl;
+using std::vector;
+using std::map;
+using std::stringstream;
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+// -----------------------------------------------------------------------------
+
+// Collect loop extents, allocation sizes and vector widths from lowered code
+class CollectLoopNests : public IRVisitor {
+private:
+    using IRVisitor::visit;
+
+    string producer;
+
+    void visit(const For *op) {
+        const int64_t *extent = as_const_int(op->extent);
+        if (extent) {
+            loop_extent[op->name] = *extent;
+        }
+        IRVisitor::visit(op);
+    }
+
+    void visit(const Allocate *op) {
+        int64_t bytes = op->type.bytes();
+        for (size_t i=0; bytes>=0 && i<op->extents.size(); i++) {
+            const int64_t *extent = as_const_int(op->extents[i]);
+            bytes = (extent ? bytes*(*extent) : -1);
+        }
+        allocation_bytes[op->name] = bytes;
+        IRVisitor::visit(op);
+    }
+
+    void visit(const ProducerConsumer *op) {
+        string enclosing = producer;
+        if (op->is_producer) {
+            producer = op->name;
+        }
+        IRVisitor::visit(op);
+        producer = enclosing;
+    }
+
+    void visit(const Ramp *op) {
+        vector_width[producer] = std::max(vector_width[producer], op->lanes);
+        IRVisitor::visit(op);
+    }
+
+public:
+    map<string, int64_t> loop_extent;       ///< constant extent of each loop by loop name
+    map<string, int64_t> allocation_bytes;  ///< size of each allocation, -1 if not constant
+    map<string, int>     vector_width;      ///< widest vector produced inside each producer
+};
+
+// Check if the scan definition contains selects or clamps
+class CollectScanBranches : public IRVisitor {
+private:
+    using IRVisitor::visit;
+    void visit(const Select *op) { has_select = true; IRVisitor::visit(op); }
+    void visit(const Min    *op) { has_clamp  = true; IRVisitor::visit(op); }
+    void visit(const Max    *op) { has_clamp  = true; IRVisitor::visit(op); }
+public:
+    bool has_select;
+    bool has_clamp;
+    CollectScanBranches(void) : has_select(false), has_clamp(false) {}
+};
+
+// -----------------------------------------------------------------------------
+
+/** Extent of a loop var of a definition; taken from lowered code if the loop
+ * survives lowering, otherwise from the split that created it */
+static int64_t loop_var_extent(
+        string loop_name,
+        string var,
+        const vector<Split> &splits,
+        CollectLoopNests &lowered)
+{
+    if (lowered.loop_extent.find(loop_name) != lowered.loop_extent.end()) {
+        return lowered.loop_extent[loop_name];
+    }
+    for (int i=0; i<splits.size(); i++) {
+        if (splits[i].split_type==Split::SplitVar && splits[i].inner==var) {
+            const int64_t *factor = as_const_int(splits[i].factor);
+            if (factor) {
+                return *factor;
+            }
+        }
+    }
+    return 0;
+}
+
+// -----------------------------------------------------------------------------
+
+vector<RecFilterLoopNest> RecFilter::loop_report(void) {
+    auto ptr = contents.get();
+
+    if (!ptr->finalized) {
+        finalize();
+    }
+
+    // lower the pipeline to find loop extents and allocation sizes
+    Func F = as_func();
+    Module m = F.compile_to_module(F.infer_arguments(), ptr->name, ptr->target);
+
+    CollectLoopNests lowered;
+    for (int i=0; i<m.functions().size(); i++) {
+        m.functions()[i].body.accept(&lowered);
+    }
+
+    vector<RecFilterLoopNest> report;
+
+    map<string,RecFilterFunc>::iterator fit;
+    for (fit=ptr->func.begin(); fit!=ptr->func.end(); fit++) {
+        RecFilterFunc& rf = fit->second;
+        Function f = rf.func;
+
+        stringstream tag;
+        tag << rf.func_category;
+
+        // compute level of the function
+        string compute_level;
+        LoopLevel level = f.schedule().compute_level();
+        if (level.is_inlined() && f.name()!=ptr->name) {
+            compute_level = "inline";
+        } else if (level.is_root() || f.name()==ptr->name) {
+            compute_level = "root";
+        } else {
+            compute_level = level.to_string();
+        }
+
+        // storage of the function; the output is written to the realization buffers
+        int64_t storage = -1;
+        if (f.name() == ptr->name) {
+            storage = f.output_types()[0].bytes() * f.outputs();
+            for (int i=0; i<ptr->filter_info.size(); i++) {
+                storage *= (ptr->filter_info[i].image_width-2*ptr->filter_info[i].border_margin) /
+                    ptr->filter_info[i].output_stride;
+            }
+        } else if (compute_level != "inline") {
+            map<string,int64_t>::iterator a;
+            for (a=lowered.allocation_bytes.begin(); a!=lowered.allocation_bytes.end(); a++) {
+                if (a->first==f.name() || a->first.find(f.name()+".")==0) {
+                    if (a->second < 0) {
+                        storage = -1;
+                        break;
+                    }
+                    storage = std::max<int64_t>(storage, 0) + a->second;
+                }
+            }
+        }
+
+        for (int d=-1; d<int(f.updates().size()); d++) {
+            Definition def = (d<0 ? f.definition() : f.update(d));
+
+            RecFilterLoopNest nest;
+            nest.name          = f.name();
+            nest.func_tag      = tag.str();
+            nest.compute_level = compute_level;
+            nest.definition    = d;
+            nest.storage_bytes = storage;
+            nest.scan          = false;
+            nest.scan_select   = false;
+            nest.scan_clamp    = false;
+
+            // loops listed outermost first, dims are stored innermost first
+            const vector<Dim>& dims = def.schedule().dims();
+            string prefix = f.name() + ".s" + std::to_string(d+1) + ".";
+            for (int i=dims.size()-1; i>=0; i--) {
+                if (dims[i].var == Var::outermost().name()) {
+                    continue;
+                }
+                RecFilterLoop loop;
+                stringstream type;
+                type << dims[i].for_type;
+                loop.var    = dims[i].var;
+                loop.type   = type.str();
+                loop.extent = loop_var_extent(prefix+dims[i].var, dims[i].var,
+                        def.schedule().splits(), lowered);
+                if (loop.extent==0 && dims[i].for_type==ForType::Vectorized) {
+                    loop.extent = lowered.vector_width[f.name()];
+                }
+                nest.loops.push_back(loop);
+            }
+
+            // selects and clamps inside scans
+            if (d >= 0) {
+                map<string,VarTag>::iterator v;
+                for (v=rf.update_var_category[d].begin(); v!=rf.update_var_category[d].end(); v++) {
+                    nest.scan |= (v->second.check(SCAN) != 0);
+                }
+                if (nest.scan) {
+                    CollectScanBranches branches;
+                    for (int i=0; i<def.values().size(); i++) {
+                        def.values()[i].accept(&branches);
+                    }
+                    for (int i=0; i<def.args().size(); i++) {
+                        def.args()[i].accept(&branches);
+                    }
+                    nest.scan_select = branches.has_select;
+                    nest.scan_clamp  = branches.has_clamp;
+                }
+            }
+
+            report.push_back(nest);
+        }
+    }
+
+    return report;
+}
+
+string RecFilter::print_loop_report(void) {
+    vector<RecFilterLoopNest> report = loop_report();
+
+    stringstream s;
+    for (int i=0; i<report.size(); i++) {
+        RecFilterLoopNest& n = report[i];
+
+        s << n.name;
+        if (n.definition >= 0) {
+            s << ".update(" << n.definition << ")";
+        }
+        s << " [" << n.func_tag << ", " << n.compute_level;
+        if (n.definition<0 && n.storage_bytes>=0) {
+            s << ", " << n.storage_bytes << " bytes";
+        }
+        s << "]";
+        if (n.scan) {
+            s << " scan";
+            s << (n.scan_select ? " with select" : "");
+            s << (n.scan_clamp  ? " with clamp"  : "");
+        }
+        s << "\n";
+
+        for (int j=0; j<n.loops.size(); j++) {
+            s << string(2*j+4, ' ') << n.loops[j].type << " " << n.loops[j].var;
+            if (n.loops[j].extent > 0) {
+                s << " : " << n.loops[j].extent;
+            }
+            s << "\n";
+        }
+    }
+    return s.str();
+}
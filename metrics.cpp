@@ -0,0 +1,143 @@
+#include "recfilter.h"
+#include "recfilter_internals.h"
+#include "profiling.h"
+
+#include <fstream>
+
+using std::string;
+using std::cerr;
+using std::endl;
+using std::vector;
+using std::stringstream;
+
+// -----------------------------------------------------------------------------
+
+LatencyHistogram::LatencyHistogram(void) : count(0), sum_ns(0) {
+    for (int i=0; i<NUM_LATENCY_BUCKETS; i++) {
+        bucket[i] = 0;
+    }
+}
+
+void LatencyHistogram::record(uint64_t ns) {
+    // index of the smallest power of two microseconds larger than the sample
+    uint64_t us = ns/1000;
+    int i = 0;
+    while (i<NUM_LATENCY_BUCKETS-1 && (uint64_t(1)<<i) <= us) {
+        i++;
+    }
+    bucket[i].fetch_add(1, std::memory_order_relaxed);
+    count   .fetch_add(1, std::memory_order_relaxed);
+    sum_ns  .fetch_add(ns,std::memory_order_relaxed);
+}
+
+// -----------------------------------------------------------------------------
+
+/** Copy a histogram into a metrics snapshot */
+static void snapshot_histogram(
+        const LatencyHistogram &h,
+        vector<uint64_t> &buckets,
+        uint64_t &count,
+        double &sum_ms)
+{
+    buckets = vector<uint64_t>(NUM_LATENCY_BUCKETS);
+    for (int i=0; i<NUM_LATENCY_BUCKETS; i++) {
+        buckets[i] = h.bucket[i].load(std::memory_order_relaxed);
+    }
+    count  = h.count.load(std::memory_order_relaxed);
+    sum_ms = h.sum_ns.load(std::memory_order_relaxed) / 1e6;
+}
+
+/** Print a histogram in Prometheus text format with cumulative buckets in seconds */
+static void print_prometheus_histogram(
+        stringstream &s,
+        string metric,
+        string help,
+        string labels,
+        const vector<uint64_t> &buckets,
+        uint64_t count,
+        double sum_ms)
+{
+    s << "# HELP " << metric << " " << help << "\n";
+    s << "# TYPE " << metric << " histogram\n";
+    uint64_t cumulative = 0;
+    for (int i=0; i<NUM_LATENCY_BUCKETS-1; i++) {
+        cumulative += buckets[i];
+        s << metric << "_bucket{" << labels << ",le=\"" << (uint64_t(1)<<i)/1e6 << "\"} "
+          << cumulative << "\n";
+    }
+    s << metric << "_bucket{" << labels << ",le=\"+Inf\"} " << count << "\n";
+    s << metric << "_sum{"    << labels << "} " << sum_ms/1e3 << "\n";
+    s << metric << "_count{"  << labels << "} " << count << "\n";
+}
+
+/** Print a counter in Prometheus text format */
+static void print_prometheus_counter(
+        stringstream &s,
+        string metric,
+        string help,
+        string labels,
+        uint64_t value)
+{
+    s << "# HELP " << metric << " " << help << "\n";
+    s << "# TYPE " << metric << " counter\n";
+    s << metric << "{" << labels << "} " << value << "\n";
+}
+
+// -----------------------------------------------------------------------------
+
+RecFilterMetrics RecFilter::metrics(void) const {
+    auto ptr = contents.get();
+
+    const MetricsInfo& m = ptr->metrics;
+
+    RecFilterMetrics r;
+    r.name               = ptr->name;
+    r.realize_count      = m.realize_count     .load(std::memory_order_relaxed);
+    r.pixels             = m.pixels            .load(std::memory_order_relaxed);
+    r.compile_count      = m.compile_count     .load(std::memory_order_relaxed);
+    r.compile_cache_hits = m.compile_cache_hits.load(std::memory_order_relaxed);
+    snapshot_histogram(m.compile_latency, r.compile_latency, r.compile_latency_count, r.compile_latency_sum_ms);
+    snapshot_histogram(m.execute_latency, r.execute_latency, r.execute_latency_count, r.execute_latency_sum_ms);
+    return r;
+}
+
+string RecFilter::print_metrics(void) const {
+    RecFilterMetrics m = metrics();
+
+    string labels = "filter=\"" + m.name + "\"";
+
+    stringstream s;
+    print_prometheus_counter(s, "recfilter_realize_total",
+            "Number of realizations", labels, m.realize_count);
+    print_prometheus_counter(s, "recfilter_pixels_total",
+            "Number of output pixels produced", labels, m.pixels);
+    print_prometheus_counter(s, "recfilter_compile_total",
+            "Number of JIT compilations", labels, m.compile_count);
+    print_prometheus_counter(s, "recfilter_compile_cache_hits_total",
+            "Number of realizations that reused the compiled pipeline", labels, m.compile_cache_hits);
+    print_prometheus_histogram(s, "recfilter_compile_latency_seconds",
+            "Latency of JIT compilation", labels,
+            m.compile_latency, m.compile_latency_count, m.compile_latency_sum_ms);
+    print_prometheus_histogram(s, "recfilter_execute_latency_seconds",
+            "Latency of realizations excluding compilation", labels,
+            m.execute_latency, m.execute_latency_count, m.execute_latency_sum_ms);
+    return s.str();
+}
+
+void RecFilter::dump_metrics(string filename) const {
+    // write to a temporary file and rename so that scrapers never see a partial file
+    string tmp_filename = filename + ".tmp";
+
+    std::ofstream fout(tmp_filename);
+    if (!fout.is_open()) {
+        cerr << "Could not open " << tmp_filename << " to dump metrics" << endl;
+        assert(false);
+    }
+    fout << print_metrics();
+    fout.close();
+
+    if (std::rename(tmp_filename.c_str(), filename.c_str()) != 0) {
+        cerr << "Could not rename " << tmp_filename << " to " << filename << endl;
+        assert(false);
+    }
+}
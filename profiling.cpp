@@ -0,0 +1,1242 @@
+#include "recfilter.h"
+#include "recfilter_internals.h"
+#include "profiling.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <fstream>
+#include <cmath>
+#include <cstring>
+#include <cctype>
+#include <unistd.h>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <elf.h>
+#include <dlfcn.h>
+#endif
+
+using std::string;
+using std::cerr;
+using std::endl;
+using std::vector;
+using std::map;
+using std::stringstream;
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+// -----------------------------------------------------------------------------
+
+/** Profiling state of the filter being realized; the trace and task hooks are
+ * plain function pointers so they can only reach the filter through a global,
+ * claimed atomically so only one instrumented realization runs at a time */
+static std::atomic<ProfilingInfo*> active_profile(NULL);
+
+/** Thread that called RecFilter::realize() */
+static std::thread::id realize_thread;
+
+/** Stage being produced by the realizing thread, parallel loop bodies
+ * launched from the realizing thread are attributed to this stage */
+static std::atomic<int> root_stage(-1);
+
+/** Counter to generate ids for trace events that open a scope */
+static std::atomic<int> trace_event_id(1);
+
+/** Incremented on every instrumented realization, invalidates the trace
+ * buffers cached by worker threads */
+static std::atomic<uint64_t> profiling_epoch(0);
+
+/** Productions in flight on the current thread, innermost last */
+static thread_local vector<TraceEvent> open_stages;
+
+/** Trace buffer of the current thread and the realization it belongs to */
+static thread_local TraceBuffer *thread_trace_buffer = NULL;
+static thread_local uint64_t     thread_trace_epoch  = 0;
+
+/** Index of the current thread in the realization it belongs to */
+static thread_local int      thread_index       = -1;
+static thread_local uint64_t thread_index_epoch = 0;
+
+/** Index of the current thread in the current realization, assigned in the
+ * order in which threads first enter the instrumentation hooks; the realizing
+ * thread always gets index 0 */
+static int current_thread_index(ProfilingInfo *p) {
+    if (thread_index<0 || thread_index_epoch!=profiling_epoch) {
+        std::lock_guard<std::mutex> guard(p->lock);
+        thread_index       = p->num_threads++;
+        thread_index_epoch = profiling_epoch;
+    }
+    return thread_index;
+}
+
+static int current_stage(void) {
+    if (open_stages.empty()) {
+        return root_stage;
+    }
+    return open_stages.back().stage;
+}
+
+static void record_trace_event(ProfilingInfo *p, const TraceEvent &ev) {
+    // first event of this thread in this realization, allocate its buffer
+    if (!thread_trace_buffer || thread_trace_epoch != profiling_epoch) {
+        int thread = current_thread_index(p);
+        std::lock_guard<std::mutex> guard(p->lock);
+        TraceBuffer b;
+        b.thread = thread;
+        b.events = vector<TraceEvent>(p->trace_capacity);
+        b.count  = 0;
+        p->trace_buffers.push_back(b);
+        thread_trace_buffer = &p->trace_buffers.back();
+        thread_trace_epoch  = profiling_epoch;
+    }
+
+    TraceBuffer *b = thread_trace_buffer;
+    b->events[b->count % b->events.size()] = ev;
+    b->count++;
+}
+
+/** Task buffer of the current thread and the realization it belongs to */
+static thread_local TaskBuffer *thread_task_buffer = NULL;
+static thread_local uint64_t    thread_task_epoch  = 0;
+
+/** Record an iteration of a parallel loop body in the buffer of the current
+ * thread; the lock is only taken for the first iteration the thread runs in a
+ * realization, buffers are merged when the results are reported */
+static void record_task(ProfilingInfo *p, uint64_t task, int stage, const TaskSpan *span) {
+    if (!thread_task_buffer || thread_task_epoch != profiling_epoch) {
+        int thread = current_thread_index(p);
+        std::lock_guard<std::mutex> guard(p->lock);
+        TaskBuffer b;
+        b.thread    = thread;
+        b.last_task = 0;
+        p->task_buffers.push_back(b);
+        thread_task_buffer = &p->task_buffers.back();
+        thread_task_epoch  = profiling_epoch;
+    }
+
+    TaskBuffer *b = thread_task_buffer;
+
+    // consecutive iterations of a thread mostly belong to the same loop, its
+    // stage is only resolved when the thread moves to another loop body
+    if (b->last_task != task) {
+        b->task_stage.insert(std::make_pair(task, stage));
+        b->last_task = task;
+    }
+    if (span) {
+        b->task_spans[task].push_back(*span);
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+/** Subnormal value counts of the current thread and the realization they belong to */
+static thread_local DenormalCounts *thread_denormal_counts = NULL;
+static thread_local uint64_t        thread_denormal_epoch  = 0;
+
+/** Count subnormal values among the lanes of a traced store */
+template<typename T>
+static uint64_t count_subnormals(const void *value, int lanes) {
+    const T *v = static_cast<const T*>(value);
+    uint64_t count = 0;
+    for (int i=0; i<lanes; i++) {
+        count += (std::fpclassify(v[i]) == FP_SUBNORMAL ? 1 : 0);
+    }
+    return count;
+}
+
+static void record_store(ProfilingInfo *p, const halide_trace_event_t *e) {
+    if (e->type.code!=halide_type_float || !e->value) {
+        return;
+    }
+
+    map<string,int>::iterator s = p->stage_id.find(e->func);
+    if (s == p->stage_id.end()) {
+        return;
+    }
+
+    // first store of this thread in this realization, allocate its counts
+    if (!thread_denormal_counts || thread_denormal_epoch != profiling_epoch) {
+        std::lock_guard<std::mutex> guard(p->lock);
+        DenormalCounts c;
+        c.stores    = vector<uint64_t>(p->stage_name.size(), 0);
+        c.denormals = vector<uint64_t>(p->stage_name.size(), 0);
+        p->denormal_counts.push_back(c);
+        thread_denormal_counts = &p->denormal_counts.back();
+        thread_denormal_epoch  = profiling_epoch;
+    }
+
+    int lanes = e->type.lanes;
+    uint64_t denormals = 0;
+    if (e->type.bits == 32) {
+        denormals = count_subnormals<float>(e->value, lanes);
+    } else if (e->type.bits == 64) {
+        denormals = count_subnormals<double>(e->value, lanes);
+    }
+    thread_denormal_counts->stores   [s->second] += lanes;
+    thread_denormal_counts->denormals[s->second] += denormals;
+}
+
+// -----------------------------------------------------------------------------
+
+/** Read the floating point control register of the current thread */
+static uint64_t get_fp_mode(void) {
+#if defined(__SSE__) || defined(_M_X64)
+    return _mm_getcsr();
+#elif defined(__aarch64__)
+    uint64_t fpcr;
+    __asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+    return fpcr;
+#else
+    return 0;
+#endif
+}
+
+/** Write the floating point control register of the current thread */
+static void set_fp_mode(uint64_t mode) {
+#if defined(__SSE__) || defined(_M_X64)
+    _mm_setcsr(mode);
+#elif defined(__aarch64__)
+    __asm__ __volatile__("msr fpcr, %0" : : "r"(mode));
+#endif
+}
+
+/** Enable flush to zero and denormals are zero in the current thread
+ * \returns previous floating point control register
+ */
+static uint64_t begin_flush_denormals(void) {
+    uint64_t mode = get_fp_mode();
+#if defined(__SSE__) || defined(_M_X64)
+    set_fp_mode(mode | 0x8040);     // FTZ is bit 15, DAZ is bit 6 of MXCSR
+#elif defined(__aarch64__)
+    set_fp_mode(mode | (1<<24));    // FZ is bit 24 of FPCR, flushes inputs and outputs
+#endif
+    return mode;
+}
+
+/** Floating point control register of the realizing thread before realization,
+ * per thread since realizations that only flush denormals may run concurrently */
+static thread_local uint64_t realize_thread_fp_mode = 0;
+
+/** Task hook of realizations that flush denormals without any instrumentation;
+ * keeps no state, so concurrent realizations of any filters can use it */
+static int flush_denormals_task_hook(void *user_context, halide_task_t f, int idx, uint8_t *closure) {
+    uint64_t mode = begin_flush_denormals();
+    int result = f(user_context, idx, closure);
+    set_fp_mode(mode);
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+
+const char* hw_counter_name[NUM_HW_COUNTERS] = {
+    "cycles", "instructions", "L1D_misses", "L2_misses",
+    "LLC_misses", "DTLB_misses", "FP_ops"
+};
+
+/** Hardware counters of the current thread, opened as a single group so that
+ * all of them are read with one system call */
+struct HWCounterGroup {
+    bool             opened;    ///< true once opening was attempted
+    uint64_t         generation;///< value of hw_counter_generation when opened
+    int              leader;    ///< file descriptor of group leader, -1 if none
+    std::vector<int> index;     ///< counter id of each value in a group read
+};
+static thread_local HWCounterGroup hw_counters = { false, 0, -1, std::vector<int>() };
+
+/** Bit mask of hardware counters that could be opened by any thread */
+static std::atomic<int> hw_counter_available(0);
+
+/** File descriptors of the counter groups of all threads; they are closed when
+ * profiling stops, which invalidates the groups of all threads by incrementing
+ * the generation, so each thread reopens its group in the next realization */
+static std::mutex            hw_counter_lock;
+static vector<int>           hw_counter_fds;
+static std::atomic<uint64_t> hw_counter_generation(0);
+
+/** Counter values of the current thread along with the time its group was
+ * enabled and the time it was actually counting; the two differ when the
+ * kernel multiplexes more events than the processor can count at once */
+struct HWCounterSample {
+    std::vector<uint64_t> values;
+    uint64_t              enabled;
+    uint64_t              running;
+};
+
+/** Counter values at the start of a production or loop iteration on the
+ * current thread along with the totals of nested stages */
+struct HWCounterFrame {
+    int                   stage;
+    HWCounterSample       start;
+    std::vector<uint64_t> nested;
+};
+static thread_local vector<HWCounterFrame> hw_counter_frames;
+
+#if defined(__linux__)
+static int open_hw_counter(uint32_t type, uint64_t config, int group_fd) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size           = sizeof(attr);
+    attr.type           = type;
+    attr.config         = config;
+    attr.disabled       = (group_fd==-1 ? 1 : 0);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    attr.read_format    = PERF_FORMAT_GROUP |
+        PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    // count the calling thread on any cpu
+    return syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+static void open_hw_counters(ProfilingInfo *p) {
+    hw_counters.opened     = true;
+    hw_counters.generation = hw_counter_generation;
+    hw_counters.leader     = -1;
+    hw_counters.index.clear();
+
+    uint64_t cache_read_miss = (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+
+    vector<int> fds;
+    for (int i=0; i<NUM_HW_COUNTERS; i++) {
+        uint32_t type   = PERF_TYPE_HARDWARE;
+        uint64_t config = 0;
+        switch (i) {
+            case 0: config = PERF_COUNT_HW_CPU_CYCLES;   break;
+            case 1: config = PERF_COUNT_HW_INSTRUCTIONS; break;
+            case 2: type = PERF_TYPE_HW_CACHE; config = PERF_COUNT_HW_CACHE_L1D  | cache_read_miss; break;
+            case 3: type = PERF_TYPE_RAW;      config = p->raw_l2_event; break;
+            case 4: type = PERF_TYPE_HW_CACHE; config = PERF_COUNT_HW_CACHE_LL   | cache_read_miss; break;
+            case 5: type = PERF_TYPE_HW_CACHE; config = PERF_COUNT_HW_CACHE_DTLB | cache_read_miss; break;
+            case 6: type = PERF_TYPE_RAW;      config = p->raw_fp_event; break;
+        }
+
+        // L2 misses and FP ops have no generic event, only counted if raw codes are given
+        if (type==PERF_TYPE_RAW && config==0) {
+            continue;
+        }
+
+        int fd = open_hw_counter(type, config, hw_counters.leader);
+        if (fd < 0) {
+            continue;
+        }
+        if (hw_counters.leader < 0) {
+            hw_counters.leader = fd;
+        }
+        fds.push_back(fd);
+        hw_counters.index.push_back(i);
+        hw_counter_available |= (1<<i);
+    }
+
+    if (hw_counters.leader >= 0) {
+        ioctl(hw_counters.leader, PERF_EVENT_IOC_RESET,  PERF_IOC_FLAG_GROUP);
+        ioctl(hw_counters.leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    std::lock_guard<std::mutex> guard(hw_counter_lock);
+    hw_counter_fds.insert(hw_counter_fds.end(), fds.begin(), fds.end());
+}
+
+static HWCounterSample read_hw_counters(ProfilingInfo *p) {
+    if (!hw_counters.opened || hw_counters.generation != hw_counter_generation) {
+        open_hw_counters(p);
+    }
+
+    HWCounterSample sample;
+    sample.values  = vector<uint64_t>(NUM_HW_COUNTERS, 0);
+    sample.enabled = 0;
+    sample.running = 0;
+    if (hw_counters.leader >= 0) {
+        // number of values, time enabled, time running, values
+        uint64_t buffer[3+NUM_HW_COUNTERS];
+        if (read(hw_counters.leader, buffer, sizeof(buffer)) > 0) {
+            sample.enabled = buffer[1];
+            sample.running = buffer[2];
+            for (int i=0; i<buffer[0] && i<hw_counters.index.size(); i++) {
+                sample.values[hw_counters.index[i]] = buffer[3+i];
+            }
+        }
+    }
+    return sample;
+}
+
+static void close_hw_counters(void) {
+    std::lock_guard<std::mutex> guard(hw_counter_lock);
+    for (int i=0; i<hw_counter_fds.size(); i++) {
+        close(hw_counter_fds[i]);
+    }
+    hw_counter_fds.clear();
+    hw_counter_generation++;
+}
+#else
+static HWCounterSample read_hw_counters(ProfilingInfo *p) {
+    HWCounterSample sample;
+    sample.values  = vector<uint64_t>(NUM_HW_COUNTERS, 0);
+    sample.enabled = 0;
+    sample.running = 0;
+    return sample;
+}
+
+static void close_hw_counters(void) {}
+#endif
+
+static void begin_hw_counter_frame(ProfilingInfo *p, int stage) {
+    HWCounterFrame frame;
+    frame.stage  = stage;
+    frame.nested = vector<uint64_t>(NUM_HW_COUNTERS, 0);
+    frame.start  = read_hw_counters(p);
+    hw_counter_frames.push_back(frame);
+}
+
+static void end_hw_counter_frame(ProfilingInfo *p) {
+    if (hw_counter_frames.empty()) {
+        return;
+    }
+
+    HWCounterSample end = read_hw_counters(p);
+    HWCounterFrame frame = hw_counter_frames.back();
+    hw_counter_frames.pop_back();
+
+    // a multiplexed group only counts part of the time, its counts are scaled
+    // up to the whole interval; a group that never ran during the interval
+    // has nothing to scale, so the interval is only reported as unmeasured
+    uint64_t enabled  = end.enabled - frame.start.enabled;
+    uint64_t running  = end.running - frame.start.running;
+    bool     measured = (running>0 || enabled==0);
+    double   scale    = (running>0 && running<enabled ? double(enabled)/double(running) : 1.0);
+
+    // nested stages are accounted separately, keep only the exclusive part
+    vector<uint64_t> total(NUM_HW_COUNTERS, 0);
+    for (int i=0; measured && i<NUM_HW_COUNTERS; i++) {
+        total[i] = uint64_t((end.values[i] - frame.start.values[i]) * scale + 0.5);
+    }
+    if (!hw_counter_frames.empty()) {
+        for (int i=0; i<NUM_HW_COUNTERS; i++) {
+            hw_counter_frames.back().nested[i] += total[i];
+        }
+    }
+
+    int stage = (frame.stage>=0 ? frame.stage : p->stage_counters.size()-1);
+
+    std::lock_guard<std::mutex> guard(p->lock);
+    for (int i=0; i<NUM_HW_COUNTERS; i++) {
+        p->stage_counters[stage][i] += total[i] - std::min(total[i], frame.nested[i]);
+    }
+    p->stage_calls[stage]++;
+    p->stage_time_enabled[stage] += enabled;
+    p->stage_time_running[stage] += running;
+    p->stage_unmeasured  [stage] += (measured ? 0 : 1);
+}
+
+// -----------------------------------------------------------------------------
+
+static int profiling_trace_hook(void *user_context, const halide_trace_event_t *e) {
+    ProfilingInfo *p = active_profile;
+    if (!p) {
+        return 0;
+    }
+
+    int id = 0;
+    switch (e->event) {
+        case halide_trace_produce:
+            {
+                map<string,int>::iterator s = p->stage_id.find(e->func);
+
+                TraceEvent ev;
+                ev.stage      = (s==p->stage_id.end() ? -1 : s->second);
+                ev.task       = -1;
+                ev.begin      = nanosecond_timer() - p->trace_start;
+                ev.end        = ev.begin;
+                ev.dimensions = std::min(e->dimensions/2, MAX_TRACE_DIMENSIONS);
+                for (int i=0; i<ev.dimensions; i++) {
+                    ev.min   [i] = e->coordinates[2*i];
+                    ev.extent[i] = e->coordinates[2*i+1];
+                }
+                open_stages.push_back(ev);
+
+                if (p->counters) {
+                    begin_hw_counter_frame(p, ev.stage);
+                }
+
+                if (std::this_thread::get_id() == realize_thread) {
+                    root_stage = ev.stage;
+                }
+                id = trace_event_id++;
+            }
+            break;
+        case halide_trace_end_produce:
+            if (p->counters) {
+                end_hw_counter_frame(p);
+            }
+            if (!open_stages.empty()) {
+                TraceEvent ev = open_stages.back();
+                open_stages.pop_back();
+                if (p->tracing) {
+                    ev.end = nanosecond_timer() - p->trace_start;
+                    record_trace_event(p, ev);
+                }
+            }
+            if (std::this_thread::get_id() == realize_thread) {
+                root_stage = current_stage();
+            }
+            break;
+        case halide_trace_store:
+            if (p->count_denormals) {
+                record_store(p, e);
+            }
+            break;
+        case halide_trace_begin_realization:
+        case halide_trace_consume:
+        case halide_trace_begin_pipeline:
+            id = trace_event_id++;
+            break;
+        default:
+            break;
+    }
+    return id;
+}
+
+static int profiling_task_hook(void *user_context, halide_task_t f, int idx, uint8_t *closure) {
+    ProfilingInfo *p = active_profile;
+    if (!p) {
+        return f(user_context, idx, closure);
+    }
+
+    // worker threads are not owned by the filter, restore their mode afterwards
+    if (p->flush_denormals && !p->tracing && !p->counters && !p->load_balance &&
+            !p->count_denormals) {
+        uint64_t mode = begin_flush_denormals();
+        int result = f(user_context, idx, closure);
+        set_fp_mode(mode);
+        return result;
+    }
+    uint64_t fp_mode = (p->flush_denormals ? begin_flush_denormals() : 0);
+
+    int stage = current_stage();
+    uint64_t address = reinterpret_cast<uint64_t>(f);
+
+    if (p->counters) {
+        begin_hw_counter_frame(p, stage);
+    }
+
+    TraceEvent ev;
+    ev.stage      = stage;
+    ev.task       = idx;
+    ev.dimensions = 0;
+    ev.begin      = nanosecond_timer() - p->trace_start;
+    int result    = f(user_context, idx, closure);
+    ev.end        = nanosecond_timer() - p->trace_start;
+
+    if (p->counters) {
+        end_hw_counter_frame(p);
+    }
+    if (p->tracing) {
+        record_trace_event(p, ev);
+    }
+    if (p->load_balance) {
+        TaskSpan span;
+        span.thread = current_thread_index(p);
+        span.begin  = ev.begin;
+        span.end    = ev.end;
+        record_task(p, address, stage, &span);
+    } else {
+        record_task(p, address, stage, NULL);
+    }
+    if (p->flush_denormals) {
+        set_fp_mode(fp_mode);
+    }
+
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+
+/** Debugger interface through which LLVM's MCJIT registers every object it
+ * loads, with section addresses patched to where the sections were loaded;
+ * the layout is defined by GDB */
+struct jit_code_entry {
+    jit_code_entry *next_entry;
+    jit_code_entry *prev_entry;
+    const char     *symfile_addr;
+    uint64_t        symfile_size;
+};
+
+struct jit_descriptor {
+    uint32_t        version;
+    uint32_t        action_flag;
+    jit_code_entry *relevant_entry;
+    jit_code_entry *first_entry;
+};
+
+/** Name of a Halide function as it appears in symbols of compiled code */
+static string sanitized_symbol(string name) {
+    for (int i=0; i<name.size(); i++) {
+        if (!isalnum(name[i])) {
+            name[i] = '_';
+        }
+    }
+    return name;
+}
+
+/** Functions defined in an ELF object registered by the JIT, with the
+ * addresses and sizes of its symbol table */
+static vector<JITSymbol> elf_function_symbols(const char *obj, uint64_t obj_size) {
+    vector<JITSymbol> symbols;
+
+#if defined(__linux__) && defined(__LP64__)
+    if (!obj || obj_size<sizeof(Elf64_Ehdr) || memcmp(obj, ELFMAG, SELFMAG)!=0 ||
+            obj[EI_CLASS]!=ELFCLASS64) {
+        return symbols;
+    }
+
+    const Elf64_Ehdr *header = reinterpret_cast<const Elf64_Ehdr*>(obj);
+    if (header->e_shentsize != sizeof(Elf64_Shdr) ||
+            header->e_shoff + header->e_shnum*sizeof(Elf64_Shdr) > obj_size) {
+        return symbols;
+    }
+    const Elf64_Shdr *section = reinterpret_cast<const Elf64_Shdr*>(obj + header->e_shoff);
+
+    for (int i=0; i<header->e_shnum; i++) {
+        if (section[i].sh_type!=SHT_SYMTAB || section[i].sh_link>=header->e_shnum) {
+            continue;
+        }
+        const Elf64_Shdr& strtab = section[section[i].sh_link];
+        if (section[i].sh_offset+section[i].sh_size > obj_size ||
+                strtab.sh_offset+strtab.sh_size > obj_size) {
+            continue;
+        }
+
+        // relocatable object: symbol values are offsets in their section
+        const Elf64_Sym *sym = reinterpret_cast<const Elf64_Sym*>(obj + section[i].sh_offset);
+        int num_symbols = section[i].sh_size / sizeof(Elf64_Sym);
+        for (int j=0; j<num_symbols; j++) {
+            if (ELF64_ST_TYPE(sym[j].st_info)!=STT_FUNC || sym[j].st_size==0 ||
+                    sym[j].st_shndx==SHN_UNDEF || sym[j].st_shndx>=header->e_shnum ||
+                    sym[j].st_name>=strtab.sh_size) {
+                continue;
+            }
+            const char *name = obj + strtab.sh_offset + sym[j].st_name;
+
+            JITSymbol s;
+            s.symbol  = string(name, strnlen(name, strtab.sh_size-sym[j].st_name));
+            s.address = section[sym[j].st_shndx].sh_addr + sym[j].st_value;
+            s.size    = sym[j].st_size;
+            symbols.push_back(s);
+        }
+    }
+#endif
+
+    return symbols;
+}
+
+/** Append the functions of the last compiled pipeline that are not yet in the
+ * perf map of the process */
+static void append_perf_map(ProfilingInfo& p) {
+    if (p.jit_symbols.empty()) {
+        cerr << "Warning: JIT compiled code was not registered with the debugger "
+             << "interface, no perf map entries written" << endl;
+        return;
+    }
+
+    std::ofstream fout(perf_map_filename(), std::ios::app);
+    if (!fout.is_open()) {
+        cerr << "Warning: could not write perf map " << perf_map_filename() << endl;
+        return;
+    }
+    for (int i=0; i<p.jit_symbols.size(); i++) {
+        const JITSymbol& s = p.jit_symbols[i];
+        if (p.perf_map_done.count(std::make_pair(s.address, s.symbol))) {
+            continue;
+        }
+        fout << std::hex << s.address << " " << s.size << std::dec
+             << " recfilter::" << s.symbol << "[" << s.func_tag << "]" << endl;
+        p.perf_map_done.insert(std::make_pair(s.address, s.symbol));
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+uint64_t nanosecond_timer(void) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+string perf_map_filename(void) {
+    stringstream s;
+    s << "/tmp/perf-" << getpid() << ".map";
+    return s.str();
+}
+
+void RecFilter::enable_perf_map(void) {
+    auto ptr = contents.get();
+
+    // symbols of a pipeline compiled earlier are still known
+    ptr->profiling.perf_map = true;
+    if (ptr->compiled) {
+        append_perf_map(ptr->profiling);
+    }
+}
+
+void RecFilter::enable_tracing(int events_per_thread) {
+    auto ptr = contents.get();
+
+    if (events_per_thread <= 0) {
+        cerr << "RecFilter::enable_tracing(): trace buffer of each thread "
+             << "must hold at least one event" << endl;
+        assert(false);
+    }
+
+    ptr->profiling.tracing        = true;
+    ptr->profiling.trace_capacity = events_per_thread;
+    ptr->compiled = false;
+}
+
+void RecFilter::enable_hardware_counters(uint64_t raw_l2_event, uint64_t raw_fp_event) {
+    auto ptr = contents.get();
+
+#if !defined(__linux__)
+    cerr << "Warning: hardware counters are only available on Linux" << endl;
+#endif
+
+    ptr->profiling.counters     = true;
+    ptr->profiling.raw_l2_event = raw_l2_event;
+    ptr->profiling.raw_fp_event = raw_fp_event;
+    ptr->compiled = false;
+}
+
+void RecFilter::set_flush_denormals(bool flush) {
+    auto ptr = contents.get();
+
+#if !defined(__SSE__) && !defined(_M_X64) && !defined(__aarch64__)
+    if (flush) {
+        cerr << "Warning: flushing denormals is not supported on this architecture" << endl;
+    }
+#endif
+
+    // only changes the hooks installed at realization, no recompilation needed
+    ptr->profiling.flush_denormals = flush;
+}
+
+void RecFilter::enable_denormal_detection(void) {
+    auto ptr = contents.get();
+
+    ptr->profiling.count_denormals = true;
+    ptr->compiled = false;
+}
+
+void RecFilter::enable_load_balance_stats(void) {
+    auto ptr = contents.get();
+
+    ptr->profiling.load_balance = true;
+    ptr->compiled = false;
+}
+
+bool RecFilter::instrumented(void) const {
+    auto ptr = contents.get();
+    return ptr->profiling.tracing ||
+        ptr->profiling.counters || ptr->profiling.load_balance ||
+        ptr->profiling.count_denormals;
+}
+
+void RecFilter::instrument(void) {
+    auto ptr = contents.get();
+
+    if (!instrumented()) {
+        return;
+    }
+
+    ProfilingInfo& p = ptr->profiling;
+    p.stage_name.clear();
+    p.stage_tag.clear();
+    p.stage_id.clear();
+    p.stage_tiles.clear();
+
+    // JIT code of the previous compilation is released on recompilation
+    p.task_stage.clear();
+
+    // trace production of every function that is not inlined
+    map<string,RecFilterFunc>::iterator fit;
+    for (fit=ptr->func.begin(); fit!=ptr->func.end(); fit++) {
+        Function f = fit->second.func;
+
+        stringstream tag;
+        tag << fit->second.func_category;
+
+        p.stage_id[f.name()] = p.stage_name.size();
+        p.stage_name.push_back(f.name());
+        p.stage_tag.push_back(tag.str());
+
+        // dimensions of the function that index tiles
+        vector<std::pair<int,string> > tiles;
+        for (int i=0; i<f.args().size(); i++) {
+            map<string,VarTag>::iterator v = fit->second.pure_var_category.find(f.args()[i]);
+            if (v!=fit->second.pure_var_category.end() && v->second.check(OUTER)) {
+                tiles.push_back(std::make_pair(i, f.args()[i]));
+            }
+        }
+        p.stage_tiles.push_back(tiles);
+
+        if (!f.schedule().compute_level().is_inlined() || f.name()==ptr->name) {
+            Func(f).trace_realizations();
+            if (p.count_denormals) {
+                Func(f).trace_stores();
+            }
+        }
+    }
+}
+
+void RecFilter::start_profiling(Func F) {
+    auto ptr = contents.get();
+
+    ProfilingInfo& p = ptr->profiling;
+
+    // only the floating point mode of each thread changes, hooks installed by
+    // an earlier instrumented realization are replaced
+    if (!instrumented()) {
+        F.set_custom_trace(NULL);
+        F.set_custom_do_task(p.flush_denormals ? &flush_denormals_task_hook : NULL);
+        if (p.flush_denormals) {
+            realize_thread_fp_mode = begin_flush_denormals();
+        }
+        return;
+    }
+
+    ProfilingInfo *expected = NULL;
+    if (!active_profile.compare_exchange_strong(expected, &p)) {
+        cerr << "Cannot profile " << ptr->name << " while another "
+             << "instrumented filter is being realized" << endl;
+        assert(false);
+    }
+
+    p.trace_buffers.clear();
+    p.task_buffers.clear();
+    p.denormal_counts.clear();
+    p.num_threads = 0;
+    p.trace_start = nanosecond_timer();
+
+    p.stage_counters = vector<vector<uint64_t> >(p.stage_name.size()+1,
+            vector<uint64_t>(NUM_HW_COUNTERS, 0));
+    p.stage_calls    = vector<uint64_t>(p.stage_name.size()+1, 0);
+    p.stage_time_enabled = vector<uint64_t>(p.stage_name.size()+1, 0);
+    p.stage_time_running = vector<uint64_t>(p.stage_name.size()+1, 0);
+    p.stage_unmeasured   = vector<uint64_t>(p.stage_name.size()+1, 0);
+
+    realize_thread = std::this_thread::get_id();
+    root_stage     = -1;
+    profiling_epoch++;
+    current_thread_index(&p);
+
+    if (p.flush_denormals) {
+        realize_thread_fp_mode = begin_flush_denormals();
+    }
+
+    F.set_custom_trace(&profiling_trace_hook);
+    F.set_custom_do_task(&profiling_task_hook);
+}
+
+void RecFilter::stop_profiling(void) {
+    auto ptr = contents.get();
+
+    if (ptr->profiling.flush_denormals) {
+        set_fp_mode(realize_thread_fp_mode);
+    }
+
+    if (!instrumented()) {
+        return;
+    }
+
+    root_stage     = -1;
+    active_profile = NULL;
+
+    // worker threads outlive the realization, close their counter groups here
+    if (ptr->profiling.counters) {
+        close_hw_counters();
+    }
+
+    // all worker threads are done, merge the loop bodies they have run
+    {
+        ProfilingInfo& p = ptr->profiling;
+        std::lock_guard<std::mutex> guard(p.lock);
+        std::list<TaskBuffer>::const_iterator b;
+        for (b=p.task_buffers.begin(); b!=p.task_buffers.end(); b++) {
+            p.task_stage.insert(b->task_stage.begin(), b->task_stage.end());
+        }
+    }
+}
+
+void RecFilter::read_jit_symbols(void) {
+    auto ptr = contents.get();
+
+    ProfilingInfo& p = ptr->profiling;
+    p.jit_symbols.clear();
+
+    // entry point of the pipeline, named by Halide after the output function
+    string entry = sanitized_symbol(ptr->name);
+
+    // objects are registered newest first, the first one that defines the
+    // entry point holds the pipeline that was just compiled
+    jit_descriptor *jit = NULL;
+#if defined(__linux__)
+    jit = reinterpret_cast<jit_descriptor*>(dlsym(RTLD_DEFAULT, "__jit_debug_descriptor"));
+#endif
+    for (jit_code_entry *e=(jit ? jit->first_entry : NULL); e && p.jit_symbols.empty(); e=e->next_entry) {
+        vector<JITSymbol> symbols = elf_function_symbols(e->symfile_addr, e->symfile_size);
+        for (int i=0; i<symbols.size(); i++) {
+            if (symbols[i].symbol == entry) {
+                p.jit_symbols = symbols;
+                break;
+            }
+        }
+    }
+
+    // parallel loop bodies are named par_for_<entry>_<loop>, the loop name
+    // starts with the name of the function it computes
+    map<string,RecFilterFunc>::iterator fit;
+    for (int i=0; i<p.jit_symbols.size(); i++) {
+        JITSymbol& s = p.jit_symbols[i];
+
+        string loop = s.symbol;
+        string prefix = "par_for_" + entry + "_";
+        if (loop.compare(0, prefix.size(), prefix) == 0) {
+            loop = loop.substr(prefix.size());
+        }
+
+        s.func     = ptr->name;
+        s.func_tag = "UNKNOWN";
+        size_t longest = 0;
+        for (fit=ptr->func.begin(); fit!=ptr->func.end(); fit++) {
+            string f = sanitized_symbol(fit->second.func.name());
+            if (f.size()>longest && loop.find(f)!=string::npos) {
+                stringstream tag;
+                tag << fit->second.func_category;
+                s.func     = fit->second.func.name();
+                s.func_tag = tag.str();
+                longest    = f.size();
+            }
+        }
+    }
+    std::sort(p.jit_symbols.begin(), p.jit_symbols.end(),
+            [](const JITSymbol &a, const JITSymbol &b) { return a.address < b.address; });
+
+    if (p.perf_map) {
+        append_perf_map(p);
+    }
+}
+
+vector<RecFilterSymbol> RecFilter::jit_symbols(void) const {
+    auto ptr = contents.get();
+
+    const ProfilingInfo& p = ptr->profiling;
+
+    vector<RecFilterSymbol> symbols;
+    for (int i=0; i<p.jit_symbols.size(); i++) {
+        RecFilterSymbol s;
+        s.symbol   = p.jit_symbols[i].symbol;
+        s.name     = p.jit_symbols[i].func;
+        s.func_tag = p.jit_symbols[i].func_tag;
+        s.address  = p.jit_symbols[i].address;
+        s.size     = p.jit_symbols[i].size;
+        symbols.push_back(s);
+    }
+    return symbols;
+}
+
+void RecFilter::export_chrome_trace(string filename) const {
+    auto ptr = contents.get();
+
+    ProfilingInfo& p = ptr->profiling;
+
+    if (!p.tracing) {
+        cerr << "Cannot export trace of " << ptr->name << " because tracing "
+             << "was not enabled using RecFilter::enable_tracing()" << endl;
+        assert(false);
+    }
+
+    std::ofstream fout(filename);
+    if (!fout.is_open()) {
+        cerr << "Could not open " << filename << " to export trace" << endl;
+        assert(false);
+    }
+
+    // trace event format expects microseconds
+    fout << "{\"traceEvents\":[\n";
+    fout << std::fixed << std::setprecision(3);
+
+    bool first = true;
+    std::list<TraceBuffer>::const_iterator b;
+    for (b=p.trace_buffers.begin(); b!=p.trace_buffers.end(); b++) {
+        fout << (first ? "" : ",\n");
+        fout << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << b->thread
+             << ",\"args\":{\"name\":\"" << (b->thread==0 ? "realize" : "worker") << " "
+             << b->thread << "\"}}";
+        first = false;
+
+        // oldest event still in the ring buffer
+        uint64_t capacity = b->events.size();
+        uint64_t start    = (b->count > capacity ? b->count-capacity : 0);
+
+        for (uint64_t i=start; i<b->count; i++) {
+            const TraceEvent& ev = b->events[i % capacity];
+
+            string name = (ev.stage>=0 ? p.stage_name[ev.stage] : ptr->name);
+            string tag  = (ev.stage>=0 ? p.stage_tag [ev.stage] : "UNKNOWN");
+
+            fout << ",\n";
+            fout << "{\"name\":\"" << name << (ev.task>=0 ? " (parallel)" : "")
+                 << "\",\"cat\":\"" << tag
+                 << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << b->thread
+                 << ",\"ts\":"  << ev.begin/1000.0
+                 << ",\"dur\":" << (ev.end-ev.begin)/1000.0
+                 << ",\"args\":{\"tag\":\"" << tag << "\"";
+            if (ev.task >= 0) {
+                fout << ",\"iteration\":" << ev.task;
+            }
+            if (ev.stage >= 0) {
+                // tile indices from the min of the produced region along OUTER dimensions
+                const vector<std::pair<int,string> >& tiles = p.stage_tiles[ev.stage];
+                for (int j=0; j<tiles.size(); j++) {
+                    if (tiles[j].first < ev.dimensions) {
+                        fout << ",\"" << tiles[j].second << "\":\"" << ev.min[tiles[j].first];
+                        if (ev.extent[tiles[j].first] > 1) {
+                            fout << "-" << ev.min[tiles[j].first]+ev.extent[tiles[j].first]-1;
+                        }
+                        fout << "\"";
+                    }
+                }
+            }
+            fout << "}}";
+        }
+    }
+    fout << "\n],\"displayTimeUnit\":\"ns\"}\n";
+}
+
+vector<RecFilterCounters> RecFilter::hardware_counters(void) const {
+    auto ptr = contents.get();
+
+    ProfilingInfo& p = ptr->profiling;
+
+    if (!p.counters) {
+        cerr << "Cannot read hardware counters of " << ptr->name << " because they "
+             << "were not enabled using RecFilter::enable_hardware_counters()" << endl;
+        assert(false);
+    }
+
+    std::lock_guard<std::mutex> guard(p.lock);
+
+    vector<RecFilterCounters> result;
+    for (int i=0; i<p.stage_calls.size(); i++) {
+        if (p.stage_calls[i] == 0) {
+            continue;
+        }
+
+        RecFilterCounters c;
+        if (i < p.stage_name.size()) {
+            c.name     = p.stage_name[i];
+            c.func_tag = p.stage_tag[i];
+        } else {
+            c.name     = ptr->name;
+            c.func_tag = "UNKNOWN";
+        }
+        c.calls      = p.stage_calls[i];
+        c.unmeasured = p.stage_unmeasured[i];
+        c.running    = 1.0;
+        if (p.stage_time_enabled[i] > 0) {
+            c.running = double(p.stage_time_running[i]) / double(p.stage_time_enabled[i]);
+        }
+        for (int j=0; j<NUM_HW_COUNTERS; j++) {
+            if (hw_counter_available & (1<<j)) {
+                c.counters[hw_counter_name[j]] = p.stage_counters[i][j];
+            }
+        }
+        result.push_back(c);
+    }
+    return result;
+}
+
+string RecFilter::print_hardware_counters(void) const {
+    vector<RecFilterCounters> c = hardware_counters();
+
+    stringstream s;
+    s << std::left << std::setw(32) << "Function" << std::setw(10) << "Tag"
+      << std::right << std::setw(10) << "calls";
+    for (int j=0; j<NUM_HW_COUNTERS; j++) {
+        s << std::setw(16) << hw_counter_name[j];
+    }
+    s << std::setw(10) << "run %" << std::setw(12) << "unmeasured" << std::setw(8) << "IPC" << "\n";
+
+    for (int i=0; i<c.size(); i++) {
+        s << std::left << std::setw(32) << c[i].name << std::setw(10) << c[i].func_tag
+          << std::right << std::setw(10) << c[i].calls;
+        for (int j=0; j<NUM_HW_COUNTERS; j++) {
+            map<string,uint64_t>::iterator v = c[i].counters.find(hw_counter_name[j]);
+            if (v == c[i].counters.end()) {
+                s << std::setw(16) << "n/a";
+            } else {
+                s << std::setw(16) << v->second;
+            }
+        }
+        s << std::setw(10) << std::setprecision(3) << 100.0*c[i].running
+          << std::setw(12) << c[i].unmeasured;
+        if (c[i].counters.count("cycles") && c[i].counters["cycles"]>0) {
+            s << std::setw(8) << std::setprecision(3)
+              << float(c[i].counters["instructions"]) / float(c[i].counters["cycles"]);
+        }
+        s << "\n";
+    }
+    return s.str();
+}
+
+vector<RecFilterLoadBalance> RecFilter::load_balance(void) const {
+    auto ptr = contents.get();
+
+    ProfilingInfo& p = ptr->profiling;
+
+    if (!p.load_balance) {
+        cerr << "Cannot compute load balance of " << ptr->name << " because it was "
+             << "not enabled using RecFilter::enable_load_balance_stats()" << endl;
+        assert(false);
+    }
+
+    std::lock_guard<std::mutex> guard(p.lock);
+
+    // merge the iterations recorded by each thread
+    map<uint64_t,vector<TaskSpan> > task_spans;
+    std::list<TaskBuffer>::const_iterator b;
+    for (b=p.task_buffers.begin(); b!=p.task_buffers.end(); b++) {
+        map<uint64_t,vector<TaskSpan> >::const_iterator s;
+        for (s=b->task_spans.begin(); s!=b->task_spans.end(); s++) {
+            vector<TaskSpan>& spans = task_spans[s->first];
+            spans.insert(spans.end(), s->second.begin(), s->second.end());
+        }
+    }
+
+    vector<RecFilterLoadBalance> result;
+    map<uint64_t,int>::iterator t;
+    for (t=p.task_stage.begin(); t!=p.task_stage.end(); t++) {
+        if (task_spans.find(t->first) == task_spans.end()) {
+            continue;
+        }
+        vector<TaskSpan> spans = task_spans[t->first];
+
+        RecFilterLoadBalance l;
+        l.name       = (t->second>=0 ? p.stage_name[t->second] : ptr->name);
+        l.func_tag   = (t->second>=0 ? p.stage_tag [t->second] : "UNKNOWN");
+        l.iterations = spans.size();
+        l.thread_busy_ms = vector<double>(p.num_threads, 0.0);
+
+        // wall time is the union of all iteration intervals, the loop may be
+        // launched several times from an enclosing serial loop
+        std::sort(spans.begin(), spans.end(),
+                [](const TaskSpan &a, const TaskSpan &b) { return a.begin < b.begin; });
+        uint64_t wall = 0;
+        uint64_t open_begin = spans[0].begin;
+        uint64_t open_end   = spans[0].end;
+        for (int i=0; i<spans.size(); i++) {
+            if (spans[i].begin > open_end) {
+                wall += open_end - open_begin;
+                open_begin = spans[i].begin;
+            }
+            open_end = std::max(open_end, spans[i].end);
+            l.thread_busy_ms[spans[i].thread] += (spans[i].end-spans[i].begin)/1e6;
+        }
+        wall += open_end - open_begin;
+        l.wall_ms = wall/1e6;
+
+        l.busy_ms = 0;
+        l.threads = 0;
+        double max_busy_ms = 0;
+        for (int i=0; i<l.thread_busy_ms.size(); i++) {
+            l.busy_ms  += l.thread_busy_ms[i];
+            l.threads  += (l.thread_busy_ms[i]>0 ? 1 : 0);
+            max_busy_ms = std::max(max_busy_ms, l.thread_busy_ms[i]);
+        }
+
+        // imbalance over all threads of the realization, idle threads count
+        double mean_busy_ms = l.busy_ms / std::max(p.num_threads, 1);
+        l.imbalance   = (mean_busy_ms>0 ? max_busy_ms/mean_busy_ms : 1.0);
+        l.utilization = (l.wall_ms>0 ? l.busy_ms/(l.wall_ms*p.num_threads) : 1.0);
+
+        result.push_back(l);
+    }
+    return result;
+}
+
+string RecFilter::print_load_balance(void) const {
+    vector<RecFilterLoadBalance> l = load_balance();
+
+    stringstream s;
+    s << std::left << std::setw(32) << "Function" << std::setw(10) << "Tag"
+      << std::right << std::setw(12) << "iterations" << std::setw(10) << "threads"
+      << std::setw(12) << "wall ms" << std::setw(12) << "busy ms"
+      << std::setw(12) << "idle ms" << std::setw(12) << "imbalance"
+      << std::setw(12) << "util %" << "\n";
+
+    s << std::fixed << std::setprecision(3);
+    for (int i=0; i<l.size(); i++) {
+        double idle_ms = l[i].wall_ms*l[i].thread_busy_ms.size() - l[i].busy_ms;
+        s << std::left << std::setw(32) << l[i].name << std::setw(10) << l[i].func_tag
+          << std::right << std::setw(12) << l[i].iterations << std::setw(10) << l[i].threads
+          << std::setw(12) << l[i].wall_ms << std::setw(12) << l[i].busy_ms
+          << std::setw(12) << std::max(idle_ms, 0.0) << std::setw(12) << l[i].imbalance
+          << std::setw(12) << 100.0*l[i].utilization << "\n";
+    }
+    return s.str();
+}
+
+vector<RecFilterDenormals> RecFilter::denormal_counts(void) const {
+    auto ptr = contents.get();
+
+    ProfilingInfo& p = ptr->profiling;
+
+    if (!p.count_denormals) {
+        cerr << "Cannot count subnormal values of " << ptr->name << " because it was "
+             << "not enabled using RecFilter::enable_denormal_detection()" << endl;
+        assert(false);
+    }
+
+    std::lock_guard<std::mutex> guard(p.lock);
+
+    vector<RecFilterDenormals> result;
+    for (int i=0; i<p.stage_name.size(); i++) {
+        RecFilterDenormals d;
+        d.name      = p.stage_name[i];
+        d.func_tag  = p.stage_tag[i];
+        d.stores    = 0;
+        d.denormals = 0;
+
+        std::list<DenormalCounts>::const_iterator c;
+        for (c=p.denormal_counts.begin(); c!=p.denormal_counts.end(); c++) {
+            d.stores    += c->stores[i];
+            d.denormals += c->denormals[i];
+        }
+        if (d.stores > 0) {
+            result.push_back(d);
+        }
+    }
+    return result;
+}
+
+string RecFilter::print_denormal_counts(void) const {
+    vector<RecFilterDenormals> d = denormal_counts();
+
+    stringstream s;
+    s << std::left << std::setw(32) << "Function" << std::setw(10) << "Tag"
+      << std::right << std::setw(16) << "stores" << std::setw(16) << "subnormals"
+      << std::setw(12) << "%" << "\n";
+
+    s << std::fixed << std::setprecision(3);
+    for (int i=0; i<d.size(); i++) {
+        s << std::left << std::setw(32) << d[i].name << std::setw(10) << d[i].func_tag
+          << std::right << std::setw(16) << d[i].stores << std::setw(16) << d[i].denormals
+          << std::setw(12) << 100.0*d[i].denormals/d[i].stores << "\n";
+    }
+    return s.str();
+}
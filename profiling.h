@@ -0,0 +1,167 @@
+#ifndef _PROFILING_H_
+#define _PROFILING_H_
+
+#include <map>
+#include <set>
+#include <list>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/** Maximum number of dimensions of a produced region recorded in a trace event */
+#define MAX_TRACE_DIMENSIONS 4
+
+/** Number of hardware counters read around every stage */
+#define NUM_HW_COUNTERS 7
+
+/** Begin and end of a function production or of a parallel loop iteration */
+struct TraceEvent {
+    int      stage;         ///< index of the traced function, -1 if unknown
+    int      task;          ///< parallel loop iteration, -1 for function productions
+    uint64_t begin;         ///< begin time in nanoseconds since tracing started
+    uint64_t end;           ///< end time in nanoseconds since tracing started
+    int      dimensions;    ///< number of dimensions of the produced region
+    int32_t  min   [MAX_TRACE_DIMENSIONS];  ///< min of produced region in each dimension
+    int32_t  extent[MAX_TRACE_DIMENSIONS];  ///< extent of produced region in each dimension
+};
+
+/** Ring buffer of trace events written by a single thread */
+struct TraceBuffer {
+    int                     thread; ///< index of the thread that owns the buffer
+    std::vector<TraceEvent> events; ///< ring buffer, oldest events are overwritten
+    uint64_t                count;  ///< number of events written so far
+};
+
+/** Execution of one iteration of a parallel loop by a thread */
+struct TaskSpan {
+    int      thread;        ///< index of the thread that ran the iteration
+    uint64_t begin;         ///< begin time in nanoseconds since profiling started
+    uint64_t end;           ///< end time in nanoseconds since profiling started
+};
+
+/** Parallel loop bodies run by a single thread along with the stage that
+ * launched them and the iterations the thread executed */
+struct TaskBuffer {
+    int                    thread;      ///< index of the thread that owns the buffer
+    uint64_t               last_task;   ///< loop body of the previous iteration, 0 if none
+    std::map<uint64_t,int> task_stage;  ///< stage computed by each loop body
+    std::map<uint64_t,std::vector<TaskSpan> > task_spans; ///< iterations of each loop body
+};
+
+/** Function of the JIT compiled pipeline, read from the symbol table of the
+ * object the JIT registered with the debugger interface */
+struct JITSymbol {
+    std::string symbol;     ///< name of the compiled function
+    std::string func;       ///< filter function it computes, filter name if unknown
+    std::string func_tag;   ///< function tag of the filter function
+    uint64_t    address;    ///< load address of the code
+    uint64_t    size;       ///< size of the code in bytes
+};
+
+/** Number of stores and subnormal values stored by a single thread for
+ * each traced function */
+struct DenormalCounts {
+    std::vector<uint64_t> stores;       ///< number of floating point values stored
+    std::vector<uint64_t> denormals;    ///< number of subnormal values stored
+};
+
+/** Instrumentation state of a recursive filter, filled by the trace and task
+ * hooks that are installed in the JIT compiled pipeline during realization */
+struct ProfilingInfo {
+    bool perf_map;                          ///< emit /tmp/perf-<pid>.map entries for JIT code
+    bool tracing;                           ///< record trace events in per thread ring buffers
+    int  trace_capacity;                    ///< capacity of each per thread ring buffer
+    bool counters;                          ///< read hardware counters around every stage
+    uint64_t raw_l2_event;                  ///< raw perf event code for L2 misses, 0 if unused
+    uint64_t raw_fp_event;                  ///< raw perf event code for FP ops, 0 if unused
+    bool load_balance;                      ///< record per thread busy time of parallel loops
+    bool flush_denormals;                   ///< set flush to zero and denormals are zero mode
+    bool count_denormals;                   ///< count subnormal values stored by each function
+
+    std::vector<std::string> stage_name;    ///< name of each function that can be traced
+    std::vector<std::string> stage_tag;     ///< function tag of each traced function
+    std::map<std::string,int> stage_id;     ///< index of each traced function by name
+
+    /** Tile index vars of each traced function as pairs of dimension and
+     * name, extracted from the OUTER tags of its pure definition */
+    std::vector<std::vector<std::pair<int,std::string> > > stage_tiles;
+
+    std::map<uint64_t,int> task_stage;      ///< stage computed by each parallel loop body, merged from task buffers after realization
+    std::vector<JITSymbol> jit_symbols;     ///< functions of the last compiled pipeline sorted by address
+
+    /** Functions already written to the perf map as pairs of address and
+     * name; code of a released pipeline may be reused by a later one */
+    std::set<std::pair<uint64_t,std::string> > perf_map_done;
+
+    std::list<TraceBuffer> trace_buffers;   ///< trace event ring buffers, one per thread
+    uint64_t               trace_start;     ///< time when tracing of the last realization started
+
+    /** Hardware counter totals of each stage excluding nested stages, the
+     * last row holds events that could not be attributed to any stage */
+    std::vector<std::vector<uint64_t> > stage_counters;
+    std::vector<uint64_t> stage_calls;      ///< number of productions or loop iterations of each stage
+    std::vector<uint64_t> stage_time_enabled;   ///< time the counters of each stage were enabled
+    std::vector<uint64_t> stage_time_running;   ///< time the counters of each stage were counting
+    std::vector<uint64_t> stage_unmeasured;     ///< productions or iterations during which the counters never ran
+
+    std::list<TaskBuffer> task_buffers;     ///< parallel loop bodies and iterations, one per thread
+    int num_threads;                        ///< number of threads seen in the last realization
+
+    std::list<DenormalCounts> denormal_counts;  ///< subnormal value counts, one per thread
+
+    std::mutex lock;                        ///< guards members written by worker threads
+
+    ProfilingInfo(void) :
+        perf_map(false), tracing(false), trace_capacity(0), counters(false),
+        raw_l2_event(0), raw_fp_event(0), load_balance(false),
+        flush_denormals(false), count_denormals(false), trace_start(0),
+        num_threads(0) {}
+};
+
+// ----------------------------------------------------------------------------
+
+/** Number of buckets of latency histograms; bucket i counts latencies less
+ * than 2^i microseconds that did not fit in bucket i-1, the last bucket counts
+ * everything larger */
+#define NUM_LATENCY_BUCKETS 24
+
+/** Latency histogram with power of two buckets, updated with relaxed atomics */
+struct LatencyHistogram {
+    std::atomic<uint64_t> bucket[NUM_LATENCY_BUCKETS];  ///< number of samples in each bucket
+    std::atomic<uint64_t> count;                        ///< total number of samples
+    std::atomic<uint64_t> sum_ns;                       ///< sum of all samples in nanoseconds
+
+    LatencyHistogram(void);
+
+    /** Add a sample
+     * \param ns latency in nanoseconds
+     */
+    void record(uint64_t ns);
+};
+
+/** Counters maintained for every recursive filter during its lifetime */
+struct MetricsInfo {
+    std::atomic<uint64_t> realize_count;        ///< number of realizations
+    std::atomic<uint64_t> pixels;               ///< number of output pixels produced
+    std::atomic<uint64_t> compile_count;        ///< number of JIT compilations
+    std::atomic<uint64_t> compile_cache_hits;   ///< realizations that reused the compiled pipeline
+    LatencyHistogram      compile_latency;      ///< latency of JIT compilation
+    LatencyHistogram      execute_latency;      ///< latency of realizations excluding compilation
+
+    MetricsInfo(void) : realize_count(0), pixels(0), compile_count(0), compile_cache_hits(0) {}
+};
+
+// ----------------------------------------------------------------------------
+
+/** Name of the Linux perf map file of the current process */
+std::string perf_map_filename(void);
+
+/** Monotonic clock in nanoseconds for trace events */
+uint64_t nanosecond_timer(void);
+
+/** Name of each hardware counter */
+extern const char* hw_counter_name[NUM_HW_COUNTERS];
+
+#endif // _PROFILING_H_
@@ -126,6 +126,11 @@ RecFilter::RecFilter(string name) {
     ptr->finalized      = false;
     ptr->compiled       = false;
     ptr->clamped_border = false;
+    ptr->transposed_clamped_border = false;
+    ptr->border_margin  = 0;
+    ptr->periodic_border= false;
+    ptr->normalized     = false;
+    ptr->min_weight     = 0.0f;
     ptr->feedfwd_coeff  = Buffer<float>(0);
     ptr->feedback_coeff = Buffer<float>(0,0);
 
@@ -186,6 +191,53 @@ RecFilterRefExpr RecFilter::operator()(vector<Expr> x) {
     return RecFilterRefExpr(*this, x);
 }
 
+/** Replace each var in the given expressions by its position in the image
+ * of given width, mirrored or periodic in the border margin; the expressions
+ * are then defined over the image extended by the margin on both sides */
+static void extend_image_border(
+        RecFilterContents *ptr,
+        vector<Var> vars,
+        vector<int> widths,
+        vector<Expr>& values)
+{
+    int margin = ptr->border_margin;
+    if (!margin) {
+        return;
+    }
+    for (int i=0; i<vars.size(); i++) {
+        Var  x = vars[i];
+        int  w = widths[i];
+        Expr t = (ptr->periodic_border ? (x-margin) % w : (x-margin) % (2*w));
+        if (!ptr->periodic_border) {
+            t = select(t<w, t, 2*w-1-t);
+        }
+        for (int j=0; j<values.size(); j++) {
+            values[j] = substitute(x.name(), t, values[j]);
+        }
+    }
+}
+
+/** Extend a dimension by the border margin before its first scan or taps:
+ * the initial definition, including the mask of a normalized convolution,
+ * reads the mirrored or periodic image in the margin and the dimension is
+ * widened; dimensions without scans keep the image width */
+static void extend_dimension_border(RecFilterContents *ptr, Function f, int dimension) {
+    FilterInfo& s = ptr->filter_info[dimension];
+    if (!ptr->border_margin || s.border_margin) {
+        return;
+    }
+
+    // scans in other dimensions read the initial definition at every position
+    // of this dimension, so it is modified in place
+    vector<Expr>& values = f.definition().values();
+    extend_image_border(ptr, {s.var}, {s.image_width}, values);
+
+    s.border_margin = ptr->border_margin;
+    s.image_width  += 2*s.border_margin;
+    s.tile_width    = s.image_width;
+    s.rdom          = RDom(0, s.image_width, unique_name("r"+s.var.name()));
+}
+
 void RecFilter::define(vector<RecFilterDim> pure_args, vector<Expr> pure_def) {
     auto ptr = contents.get();
 
@@ -193,6 +245,14 @@ void RecFilter::define(vector<RecFilterDim> pure_args, vector<Expr> pure_def) {
     assert(!pure_args.empty());
     assert(!pure_def.empty());
 
+    // conversion from the storage type is part of the initial definition,
+    // which is computed when loading each tile
+    if (ptr->compute_type.bits() != 0) {
+        for (int i=0; i<pure_def.size(); i++) {
+            pure_def[i] = cast(ptr->compute_type, pure_def[i]);
+        }
+    }
+
     ptr->type = pure_def[0].type();
     for (int i=1; i<pure_def.size(); i++) {
         if (ptr->type != pure_def[i].type()) {
@@ -219,9 +279,13 @@ void RecFilter::define(vector<RecFilterDim> pure_args, vector<Expr> pure_def) {
         s.filter_dim   = i;
         s.var          = pure_args[i].var();
 
-        // extent and domain of all scans in this dimension
-        s.image_width = pure_args[i].num_pixels();
-        s.tile_width  = s.image_width;
+        // extent and domain of all scans in this dimension, extended by the
+        // border margin when the first scan or taps are added
+        s.image_width   = pure_args[i].num_pixels();
+        s.border_margin = 0;
+        s.tile_width    = s.image_width;
+        s.output_stride = 1;
+        s.branch_outputs= 0;
         s.rdom        = RDom(0, s.image_width, unique_name("r"+s.var.name()));
 
         // default values for now
@@ -255,9 +319,134 @@ void RecFilter::set_clamped_image_border(void) {
         cerr << "Recursive filter " << ptr->name << " already defined" << endl;
         assert(false);
     }
+    if (ptr->border_margin) {
+        cerr << "Recursive filter " << ptr->name << " already has a mirrored or periodic border" << endl;
+        assert(false);
+    }
     ptr->clamped_border = true;
 }
 
+/** Extend the image by mirroring or periodically before the initial definition */
+static void set_extended_image_border(RecFilterContents *ptr, int margin, bool periodic) {
+    if (!ptr->filter_info.empty()) {
+        cerr << "Recursive filter " << ptr->name << " already defined" << endl;
+        assert(false);
+    }
+    if (ptr->clamped_border) {
+        cerr << "Recursive filter " << ptr->name << " already has a clamped border" << endl;
+        assert(false);
+    }
+    if (margin < 1) {
+        cerr << "Border margin of " << ptr->name << " must be positive" << endl;
+        assert(false);
+    }
+    ptr->border_margin   = margin;
+    ptr->periodic_border = periodic;
+}
+
+void RecFilter::set_mirrored_image_border(int margin) {
+    set_extended_image_border(contents.get(), margin, false);
+}
+
+void RecFilter::set_periodic_image_border(int margin) {
+    set_extended_image_border(contents.get(), margin, true);
+}
+
+void RecFilter::set_compute_type(Type t) {
+    auto ptr = contents.get();
+
+    if (!ptr->filter_info.empty()) {
+        cerr << "Recursive filter " << ptr->name << " already defined" << endl;
+        assert(false);
+    }
+    ptr->compute_type = t;
+}
+
+void RecFilter::set_output_type(Type t) {
+    auto ptr = contents.get();
+
+    if (ptr->tiled) {
+        cerr << "Output type of " << ptr->name << " must be set before tiling" << endl;
+        assert(false);
+    }
+    ptr->output_type = t;
+    ptr->compiled = false;
+}
+
+void RecFilter::set_normalized_convolution(Expr mask, float min_weight) {
+    auto ptr = contents.get();
+
+    RecFilterFunc& rf = internal_function(ptr->name);
+    Function        f = rf.func;
+
+    if (!f.has_pure_definition()) {
+        cerr << "Cannot set normalized convolution for recursive filter " << f.name()
+            << " before specifying an initial definition using RecFilter::define()" << endl;
+        assert(false);
+    }
+    bool has_taps = false;
+    for (int i=0; i<ptr->filter_info.size(); i++) {
+        has_taps |= !ptr->filter_info[i].feedfwd_taps.empty();
+    }
+    if (!f.updates().empty() || has_taps || ptr->normalized) {
+        cerr << "Normalized convolution for recursive filter " << f.name()
+            << " must be set once before adding any scans or feedforward taps" << endl;
+        assert(false);
+    }
+    if (ptr->tiled) {
+        cerr << "Normalized convolution for recursive filter " << f.name()
+            << " must be set before tiling" << endl;
+        assert(false);
+    }
+
+    // outputs are the masked image and the mask, filtered with the same scans;
+    // both are part of the initial definition, so the mask is extended over
+    // the border margin like the image
+    Expr m = cast(ptr->type, mask);
+    vector<Expr> pure_values = f.values();
+    for (int i=0; i<pure_values.size(); i++) {
+        pure_values[i] = pure_values[i] * m;
+    }
+    pure_values.push_back(m);
+
+    Function g(f.name());
+    g.define(f.args(), pure_values);
+    rf.func = g;
+
+    ptr->normalized = true;
+    ptr->min_weight = min_weight;
+    ptr->compiled   = false;
+}
+
+void RecFilter::set_output_stride(RecFilterDim x, int stride) {
+    auto ptr = contents.get();
+
+    if (ptr->tiled) {
+        cerr << "Output stride of " << ptr->name << " must be set before tiling" << endl;
+        assert(false);
+    }
+
+    int dimension = -1;
+    for (int i=0; dimension<0 && i<ptr->filter_info.size(); i++) {
+        if (ptr->filter_info[i].var.name() == x.var().name()) {
+            dimension = i;
+        }
+    }
+    if (dimension == -1) {
+        cerr << "Variable " << x << " is not one of the dimensions of the "
+            << "recursive filter " << ptr->name << endl;
+        assert(false);
+    }
+    if (stride<1 || (ptr->filter_info[dimension].image_width-2*ptr->filter_info[dimension].border_margin) % stride) {
+        cerr << "Output stride " << stride << " of " << ptr->name << " must be "
+            << "positive and divide the image width of dimension " << x << endl;
+        assert(false);
+    }
+
+    ptr->filter_info[dimension].output_stride = stride;
+    ptr->compiled = false;
+}
+
 void RecFilter::add_filter(RecFilterDim x, vector<float> coeff) {
     add_filter(RecFilterDimAndCausality(x,true), coeff);
 }
@@ -280,6 +469,14 @@ void RecFilter::add_filter(RecFilterDimAndCausality x, vector<float> coeff) {
         assert(false);
     }
 
+    for (int i=0; i<ptr->filter_info.size(); i++) {
+        if (ptr->filter_info[i].var.name()==x.var().name() && ptr->filter_info[i].branch_outputs) {
+            cerr << "Cannot add scan to recursive filter " << f.name() << " in dimension "
+                << x << " after a symmetric filter in the same dimension" << endl;
+            assert(false);
+        }
+    }
+
     bool causal = x.causal();
 
     float feedfwd = coeff[0];
@@ -302,6 +499,18 @@ void RecFilter::add_filter(RecFilterDimAndCausality x, vector<float> coeff) {
         assert(false);
     }
 
+    extend_dimension_border(ptr, f, dimension);
+
+    // taps applied to the output commute only with scans of same causality
+    for (int i=0; i<ptr->filter_info[dimension].feedfwd_taps.size(); i++) {
+        const FeedforwardTaps& taps = ptr->filter_info[dimension].feedfwd_taps[i];
+        if (taps.output && taps.causal != causal) {
+            cerr << "Cannot add scan to recursive filter " << f.name() << " in dimension "
+                << x << " after feedforward taps of opposite causality applied to the output" << endl;
+            assert(false);
+        }
+    }
+
     // reduction domain for the scan
     RDom rx    = ptr->filter_info[dimension].rdom;
     Expr width = ptr->filter_info[dimension].image_width;
@@ -394,6 +603,521 @@ void RecFilter::add_filter(RecFilterDimAndCausality x, vector<float> coeff) {
     rf.update_var_category.push_back(update_var_category);
 }
 
+void RecFilter::add_filter(RecFilterDim x, std::complex<float> feedfwd, std::complex<float> feedback) {
+    add_filter(RecFilterDimAndCausality(x,true), feedfwd, feedback);
+}
+
+void RecFilter::add_filter(RecFilterDimAndCausality x, std::complex<float> feedfwd, std::complex<float> feedback) {
+    auto ptr = contents.get();
+
+    RecFilterFunc& rf = internal_function(ptr->name);
+    Function        f = rf.func;
+
+    if (f.outputs()%2) {
+        cerr << "Cannot add complex scan to recursive filter " << f.name()
+            << " because its outputs are not pairs of real and imaginary parts" << endl;
+        assert(false);
+    }
+
+    // b/(1-a z^-1) = b(1-conj(a) z^-1) / (1 - 2Re(a) z^-1 + |a|^2 z^-2), i.e. a
+    // complex 2-tap numerator followed by a real second order scan that is
+    // identical for real and imaginary parts
+    std::complex<float> tap[2] = { feedfwd, -feedfwd*std::conj(feedback) };
+
+    // complex multiplication as 2x2 blocks of the matrix mixing the outputs
+    int n = f.outputs();
+    vector<vector<float> > weights(2, vector<float>(n*n, 0.0f));
+    for (int k=0; k<2; k++) {
+        for (int i=0; i<n; i+=2) {
+            weights[k][ i   *n + i  ] =  tap[k].real();
+            weights[k][ i   *n + i+1] = -tap[k].imag();
+            weights[k][(i+1)*n + i  ] =  tap[k].imag();
+            weights[k][(i+1)*n + i+1] =  tap[k].real();
+        }
+    }
+    add_feedforward_taps(x, weights);
+
+    add_filter(x, {1.0f, 2.0f*feedback.real(), -std::norm(feedback)});
+}
+
+void RecFilter::add_arma_filter(RecFilterDim x, vector<float> feedfwd, vector<float> feedback) {
+    add_arma_filter(RecFilterDimAndCausality(x,true), feedfwd, feedback);
+}
+
+void RecFilter::add_arma_filter(RecFilterDimAndCausality x, vector<float> feedfwd, vector<float> feedback) {
+    auto ptr = contents.get();
+
+    if (feedfwd.empty() || feedback.empty()) {
+        cerr << "Cannot add scan to recursive filter " << ptr->name
+            << " without feed forward and feedback coefficients" << endl;
+        assert(false);
+    }
+
+    vector<float> coeff = feedback;
+
+    // a single feedforward tap is an ordinary scan, otherwise the numerator
+    // is applied to the initial definition and the scan has unit feedforward
+    if (feedfwd.size() == 1) {
+        coeff.insert(coeff.begin(), feedfwd[0]);
+    } else {
+        int n = internal_function(ptr->name).func.outputs();
+        vector<vector<float> > weights(feedfwd.size(), vector<float>(n*n, 0.0f));
+        for (int k=0; k<feedfwd.size(); k++) {
+            for (int i=0; i<n; i++) {
+                weights[k][i*n+i] = feedfwd[k];
+            }
+        }
+        add_feedforward_taps(x, weights);
+        coeff.insert(coeff.begin(), 1.0f);
+    }
+
+    add_filter(x, coeff);
+}
+
+/** Product of two polynomials in z^-1 */
+static vector<double> poly_mul(const vector<double> &a, const vector<double> &b) {
+    vector<double> c(a.size()+b.size()-1, 0.0);
+    for (int i=0; i<a.size(); i++) {
+        for (int j=0; j<b.size(); j++) {
+            c[i+j] += a[i]*b[j];
+        }
+    }
+    return c;
+}
+
+/** Sum of two polynomials in z^-1 scaled by s */
+static vector<double> poly_add(const vector<double> &a, const vector<double> &b, double s) {
+    vector<double> c(std::max(a.size(), b.size()), 0.0);
+    for (int i=0; i<a.size(); i++) {
+        c[i] += a[i];
+    }
+    for (int i=0; i<b.size(); i++) {
+        c[i] += s*b[i];
+    }
+    return c;
+}
+
+/** Determinant of a matrix of polynomials by cofactor expansion along the
+ * first row; matrices are small, one row per output of the filter */
+static vector<double> poly_det(const vector<vector<vector<double> > > &m) {
+    int n = m.size();
+    if (n == 1) {
+        return m[0][0];
+    }
+    vector<double> d(1, 0.0);
+    for (int j=0; j<n; j++) {
+        vector<vector<vector<double> > > minor;
+        for (int u=1; u<n; u++) {
+            vector<vector<double> > row;
+            for (int v=0; v<n; v++) {
+                if (v != j) {
+                    row.push_back(m[u][v]);
+                }
+            }
+            minor.push_back(row);
+        }
+        d = poly_add(d, poly_mul(m[0][j], poly_det(minor)), (j%2 ? -1.0 : 1.0));
+    }
+    return d;
+}
+
+/** Roots of z^m + c[1] z^(m-1) + ... + c[m] for c[0]=1 by Durand-Kerner
+ * iteration, i.e. the poles of 1/(c[0] + c[1] z^-1 + ... + c[m] z^-m);
+ * repeated roots converge linearly, to a few digits less than double */
+static vector<std::complex<double> > poly_poles(const vector<double> &c) {
+    int m = c.size()-1;
+
+    vector<std::complex<double> > z(m);
+    for (int i=0; i<m; i++) {
+        z[i] = std::pow(std::complex<double>(0.4, 0.9), i);
+    }
+    for (int iter=0; iter<500; iter++) {
+        for (int i=0; i<m; i++) {
+            std::complex<double> f = 0.0;
+            std::complex<double> d = 1.0;
+            for (int k=0; k<=m; k++) {
+                f = f*z[i] + c[k];
+            }
+            for (int j=0; j<m; j++) {
+                if (j != i) {
+                    d *= z[i]-z[j];
+                }
+            }
+            if (std::abs(d) > 0.0) {
+                z[i] -= f/d;
+            }
+        }
+    }
+    return z;
+}
+
+void RecFilter::add_filter(RecFilterDim x, vector<float> feedfwd, vector<vector<float> > feedback) {
+    add_filter(RecFilterDimAndCausality(x,true), feedfwd, feedback);
+}
+
+void RecFilter::add_filter(RecFilterDimAndCausality x, vector<float> feedfwd, vector<vector<float> > feedback) {
+    auto ptr = contents.get();
+
+    int n = internal_function(ptr->name).func.outputs();
+
+    bool valid = (feedfwd.size()==n*n && !feedback.empty());
+    for (int k=0; k<feedback.size(); k++) {
+        valid &= (feedback[k].size()==n*n);
+    }
+    if (!valid) {
+        cerr << "Cannot add scan to recursive filter " << ptr->name << " because the "
+            << "feedforward and feedback coeff are not " << n << "x" << n << " matrices" << endl;
+        assert(false);
+    }
+
+    // y = P(z)^-1 B x with P(z) = I - sum_k A_k z^-k, which is the matrix FIR
+    // filter adj(P(z)) B applied to the initial definition followed by the
+    // scalar scan 1/det(P(z)) that is identical for all outputs
+    int order = feedback.size();
+    vector<vector<vector<double> > > P(n, vector<vector<double> >(n, vector<double>(order+1, 0.0)));
+    for (int i=0; i<n; i++) {
+        P[i][i][0] = 1.0;
+        for (int j=0; j<n; j++) {
+            for (int k=0; k<order; k++) {
+                P[i][j][k+1] = -feedback[k][i*n+j];
+            }
+        }
+    }
+
+    vector<double> det = poly_det(P);
+
+    // adjugate: adj(i,j) is the cofactor of element (j,i)
+    vector<vector<vector<double> > > adj(n, vector<vector<double> >(n, vector<double>(1, 0.0)));
+    for (int i=0; i<n; i++) {
+        for (int j=0; j<n; j++) {
+            if (n == 1) {
+                adj[i][j] = vector<double>(1, 1.0);
+                continue;
+            }
+            vector<vector<vector<double> > > minor;
+            for (int u=0; u<n; u++) {
+                if (u == j) {
+                    continue;
+                }
+                vector<vector<double> > row;
+                for (int v=0; v<n; v++) {
+                    if (v != i) {
+                        row.push_back(P[u][v]);
+                    }
+                }
+                minor.push_back(row);
+            }
+            adj[i][j] = poly_det(minor);
+            if ((i+j)%2) {
+                adj[i][j] = poly_add(vector<double>(1, 0.0), adj[i][j], -1.0);
+            }
+        }
+    }
+
+    // numerator taps adj(P) B, one n x n matrix per tap
+    int num_taps = 1 + (n-1)*order;
+    vector<vector<float> > weights(num_taps, vector<float>(n*n, 0.0f));
+    for (int i=0; i<n; i++) {
+        for (int j=0; j<n; j++) {
+            for (int l=0; l<n; l++) {
+                for (int k=0; k<adj[i][l].size() && k<num_taps; k++) {
+                    weights[k][i*n+j] += float(adj[i][l][k] * feedfwd[l*n+j]);
+                }
+            }
+        }
+    }
+    // terms that cancel in the expansion are rounding noise, not exact zeros
+    double max_weight = 0.0;
+    for (int k=0; k<weights.size(); k++) {
+        for (int i=0; i<n*n; i++) {
+            max_weight = std::max(max_weight, double(std::abs(weights[k][i])));
+        }
+    }
+    while (weights.size()>1 && *std::max_element(weights.back().begin(), weights.back().end()) <= 1e-6*max_weight
+            && -*std::min_element(weights.back().begin(), weights.back().end()) <= 1e-6*max_weight) {
+        weights.pop_back();
+    }
+
+    // det(P) has unit constant term, its other terms negated are the feedback
+    double max_det = 1.0;
+    for (int k=0; k<det.size(); k++) {
+        max_det = std::max(max_det, std::abs(det[k]));
+    }
+    while (det.size()>2 && std::abs(det.back()) <= 1e-12*max_det) {
+        det.pop_back();
+    }
+    vector<float> coeff(1, 1.0f);
+    for (int k=1; k<det.size(); k++) {
+        coeff.push_back(float(-det[k]));
+    }
+
+    // the scalar scan has the poles of all coupled modes; repeated poles and
+    // poles near the unit circle are sensitive to the rounding of its
+    // coefficients to float, which can turn a stable recursion unstable
+    vector<double> rounded(1, 1.0);
+    for (int k=1; k<coeff.size(); k++) {
+        rounded.push_back(-double(coeff[k]));
+    }
+    vector<std::complex<double> > poles         = poly_poles(det);
+    vector<std::complex<double> > rounded_poles = poly_poles(rounded);
+
+    double max_radius = 0.0;
+    double max_rounded_radius = 0.0;
+    bool   repeated = false;
+    for (int i=0; i<poles.size(); i++) {
+        max_radius = std::max(max_radius, std::abs(poles[i]));
+        max_rounded_radius = std::max(max_rounded_radius, std::abs(rounded_poles[i]));
+        for (int j=i+1; j<poles.size(); j++) {
+            repeated |= (std::abs(poles[i]-poles[j]) < 1e-3);
+        }
+    }
+    if (max_radius >= 1.0) {
+        cerr << "Cannot add scan to recursive filter " << ptr->name << " because the "
+            << "coupled recursion is unstable, its largest pole has magnitude "
+            << max_radius << endl;
+        assert(false);
+    }
+    if (max_rounded_radius >= 1.0) {
+        cerr << "Cannot add scan to recursive filter " << ptr->name << " because its "
+            << "poles are too close to the unit circle or repeated: the equivalent scalar "
+            << "scan of order " << coeff.size()-1 << " diverges once its coefficients are "
+            << "rounded to float, largest pole magnitude " << max_rounded_radius << endl;
+        assert(false);
+    }
+    if (repeated || max_radius > 1.0-1e-3) {
+        cerr << "Warning: coupled recursion of " << ptr->name << " has "
+            << (repeated ? "repeated poles" : "poles near the unit circle") << ", the "
+            << "equivalent scalar scan of order " << coeff.size()-1 << " amplifies "
+            << "rounding errors; filters that do not couple outputs should be added "
+            << "as ordinary scans" << endl;
+    }
+
+    add_feedforward_taps(x, weights);
+    add_filter(x, coeff);
+}
+
+void RecFilter::add_symmetric_filter(
+        RecFilterDim x,
+        vector<float> causal_feedfwd,
+        vector<float> anticausal_feedfwd,
+        vector<float> feedback)
+{
+    auto ptr = contents.get();
+
+    RecFilterFunc& rf = internal_function(ptr->name);
+    Function        f = rf.func;
+
+    if (!f.has_pure_definition()) {
+        cerr << "Cannot add scans to recursive filter " << f.name()
+            << " before specifying an initial definition using RecFilter::define()" << endl;
+        assert(false);
+    }
+
+    if (causal_feedfwd.empty() || anticausal_feedfwd.empty() || feedback.empty()) {
+        cerr << "Cannot add symmetric filter to recursive filter " << f.name()
+            << " without feed forward and feedback coefficients" << endl;
+        assert(false);
+    }
+
+    int dimension = -1;
+    for (int i=0; dimension<0 && i<f.args().size(); i++) {
+        if (f.args()[i] == x.var().name()) {
+            dimension = i;
+        }
+    }
+    if (dimension == -1) {
+        cerr << "Variable " << x << " is not one of the dimensions of the "
+            << "recursive filter " << f.name() << endl;
+        assert(false);
+    }
+    if (ptr->filter_info[dimension].num_scans) {
+        cerr << "Cannot add symmetric filter to recursive filter " << f.name()
+            << " after other scans in dimension " << x << endl;
+        assert(false);
+    }
+    for (int i=0; i<ptr->filter_info.size(); i++) {
+        for (int j=0; j<ptr->filter_info[i].feedfwd_taps.size(); j++) {
+            if (ptr->filter_info[i].feedfwd_taps[j].output) {
+                cerr << "Cannot add symmetric filter to recursive filter " << f.name()
+                    << " after feedforward taps applied to the output" << endl;
+                assert(false);
+            }
+        }
+    }
+
+    extend_dimension_border(ptr, f, dimension);
+
+    // the anticausal branch is the causal branch of the input mirrored in x,
+    // so both branches are computed by the same causal scan over twice the
+    // outputs and summed after mirroring back by the output function
+    int  n     = f.outputs();
+    Var  var   = x.var();
+    Expr width = ptr->filter_info[dimension].image_width;
+
+    vector<Expr> pure_values = f.values();
+    for (int i=0; i<n; i++) {
+        pure_values.push_back(substitute(var.name(), width-1-var, pure_values[i]));
+    }
+
+    Function g(f.name());
+    g.define(f.args(), pure_values);
+
+    // scans in other dimensions commute with mirroring, each is applied to
+    // the mirrored outputs as well
+    for (int d=0; d<f.updates().size(); d++) {
+        Definition def = f.update(d);
+        vector<Expr> values;
+        for (int i=0; i<n; i++) {
+            values.push_back(substitute_func_call(f.name(), g, def.values()[i]));
+        }
+        for (int i=0; i<n; i++) {
+            values.push_back(increment_value_index_in_func_call(f.name(), n, values[i]));
+        }
+        g.define_update(def.args(), values);
+    }
+
+    rf.func = g;
+    ptr->compiled = false;
+
+    // causal taps for original outputs, anticausal taps become causal in
+    // mirrored outputs; branches do not mix
+    int num_taps = std::max(causal_feedfwd.size(), anticausal_feedfwd.size());
+    causal_feedfwd    .resize(num_taps, 0.0f);
+    anticausal_feedfwd.resize(num_taps, 0.0f);
+
+    vector<float> coeff = feedback;
+    if (num_taps==1 && causal_feedfwd[0]==anticausal_feedfwd[0]) {
+        coeff.insert(coeff.begin(), causal_feedfwd[0]);
+    } else {
+        vector<vector<float> > weights(num_taps, vector<float>(4*n*n, 0.0f));
+        for (int k=0; k<num_taps; k++) {
+            for (int i=0; i<n; i++) {
+                weights[k][ i   *2*n + i  ] = causal_feedfwd[k];
+                weights[k][(i+n)*2*n + i+n] = anticausal_feedfwd[k];
+            }
+        }
+        add_feedforward_taps(+x, weights);
+        coeff.insert(coeff.begin(), 1.0f);
+    }
+
+    add_filter(+x, coeff);
+
+    ptr->filter_info[dimension].branch_outputs = n;
+}
+
+void RecFilter::add_feedforward_taps(RecFilterDimAndCausality x, vector<vector<float> > weights) {
+    auto ptr = contents.get();
+
+    RecFilterFunc& rf = internal_function(ptr->name);
+    Function        f = rf.func;
+
+    if (!f.has_pure_definition()) {
+        cerr << "Cannot add scans to recursive filter " << f.name()
+            << " before specifying an initial definition using RecFilter::define()" << endl;
+        assert(false);
+    }
+
+    int dimension = -1;
+    for (int i=0; dimension<0 && i<f.args().size(); i++) {
+        if (f.args()[i] == x.var().name()) {
+            dimension = i;
+        }
+    }
+    if (dimension == -1) {
+        cerr << "Variable " << x << " is not one of the dimensions of the "
+            << "recursive filter " << f.name() << endl;
+        assert(false);
+    }
+
+    // feedforward taps are applied to the initial definition, which is exact
+    // only if they commute with all preceding scans: scans in other dimensions
+    // always do, scans in the same dimension only if they have same causality
+    // and the border is zero; otherwise they are applied to the output of all
+    // scans by the output function created by tiling, which is exact if all
+    // later scans in the same dimension have same causality; taps added after
+    // taps applied to the output follow them because taps mixing the outputs
+    // need not commute
+    if (ptr->clamped_border) {
+        cerr << "Cannot add feedforward taps to recursive filter " << f.name()
+            << " because the image border is clamped" << endl;
+        assert(false);
+    }
+
+    extend_dimension_border(ptr, f, dimension);
+
+    FilterInfo& s = ptr->filter_info[dimension];
+
+    bool output = false;
+    for (int i=0; i<s.num_scans; i++) {
+        output |= (s.scan_causal[i] != x.causal());
+    }
+    for (int i=0; i<ptr->filter_info.size(); i++) {
+        for (int j=0; j<ptr->filter_info[i].feedfwd_taps.size(); j++) {
+            output |= ptr->filter_info[i].feedfwd_taps[j].output;
+        }
+    }
+    for (int i=0; i<s.feedfwd_taps.size(); i++) {
+        if (s.feedfwd_taps[i].output && s.feedfwd_taps[i].causal != x.causal()) {
+            cerr << "Cannot add feedforward taps to recursive filter " << f.name()
+                << " because taps of opposite causality are applied to the output "
+                << "in dimension " << x << endl;
+            assert(false);
+        }
+    }
+    for (int i=0; output && i<ptr->filter_info.size(); i++) {
+        if (ptr->filter_info[i].branch_outputs) {
+            cerr << "Cannot add feedforward taps to the output of recursive filter "
+                << f.name() << " because it contains a symmetric filter" << endl;
+            assert(false);
+        }
+    }
+
+    FeedforwardTaps taps;
+    taps.id      = 0;
+    taps.causal  = x.causal();
+    taps.output  = output;
+    taps.weights = weights;
+    for (int i=0; i<ptr->filter_info.size(); i++) {
+        taps.id += ptr->filter_info[i].feedfwd_taps.size();
+    }
+    s.feedfwd_taps.push_back(taps);
+    ptr->compiled = false;
+
+    if (output) {
+        return;
+    }
+
+    int  n     = f.outputs();
+    Var  var   = x.var();
+    Expr width = ptr->filter_info[dimension].image_width;
+
+    vector<Expr>& values = f.definition().values();
+    vector<Expr>  pure_values = values;
+
+    for (int i=0; i<n; i++) {
+        values[i] = make_zero(ptr->type);
+        for (int k=0; k<weights.size(); k++) {
+            for (int j=0; j<n; j++) {
+                float w = weights[k][i*n+j];
+                if (w == 0.0f) {
+                    continue;
+                }
+
+                // taps read pixels before x for causal and after x for
+                // anticausal filters, pixels outside the image are zero
+                Expr v = pure_values[j];
+                if (k > 0) {
+                    Expr xk = (x.causal() ? var-k : var+k);
+                    v = select(x.causal() ? var>=k : var<width-k,
+                            substitute(var.name(), xk, v), make_zero(ptr->type));
+                }
+                values[i] += Cast::make(ptr->type, w) * v;
+            }
+        }
+        values[i] = simplify(values[i]);
+    }
+}
+
 // -----------------------------------------------------------------------------
 
 RecFilterSchedule RecFilter::full_schedule(void) {
@@ -946,6 +1670,67 @@ RecFilterFunc& RecFilter::internal_function(string func_name) {
 
 // -----------------------------------------------------------------------------
 
+/** Definitions, schedules and instrumentation of a function and of all
+ * functions it calls, including functions of other filters and external
+ * funcs; compiled code is valid for as long as this does not change, however
+ * the functions were scheduled */
+static string pipeline_signature(Function F, Target target) {
+    map<string,Function> env = find_transitive_calls(F);
+    env[F.name()] = F;
+
+    stringstream s;
+    s << target.to_string() << "\n";
+
+    map<string,Function>::iterator e;
+    for (e=env.begin(); e!=env.end(); e++) {
+        Function f = e->second;
+        const FuncSchedule& fs = f.schedule();
+
+        s << f.name()
+          << " compute " << fs.compute_level().to_string()
+          << " store "   << fs.store_level().to_string()
+          << " trace "   << f.is_tracing_realizations() << f.is_tracing_stores() << "\n";
+        for (int i=0; i<fs.bounds().size(); i++) {
+            const Bound& b = fs.bounds()[i];
+            s << " bound " << b.var << " " << b.min << " " << b.extent << "\n";
+        }
+        for (int i=0; i<fs.storage_dims().size(); i++) {
+            s << " storage " << fs.storage_dims()[i].var << "\n";
+        }
+
+        vector<Definition> defs;
+        defs.push_back(f.definition());
+        defs.insert(defs.end(), f.updates().begin(), f.updates().end());
+        for (int d=0; d<defs.size(); d++) {
+            if (!defs[d].defined()) {
+                continue;
+            }
+            s << " def";
+            for (int i=0; i<defs[d].args().size(); i++) {
+                s << " " << defs[d].args()[i];
+            }
+            s << " =";
+            for (int i=0; i<defs[d].values().size(); i++) {
+                s << " " << defs[d].values()[i];
+            }
+            s << "\n";
+
+            const StageSchedule& ss = defs[d].schedule();
+            for (int i=0; i<ss.splits().size(); i++) {
+                const Split& sp = ss.splits()[i];
+                s << "  split " << sp.old_var << " " << sp.outer << " " << sp.inner << " "
+                  << sp.factor << " " << int(sp.split_type) << " " << int(sp.tail) << "\n";
+            }
+            for (int i=0; i<ss.dims().size(); i++) {
+                const Dim& dim = ss.dims()[i];
+                s << "  dim " << dim.var << " " << int(dim.for_type) << " " << int(dim.device_api) << "\n";
+            }
+            s << "  race " << ss.allow_race_conditions() << "\n";
+        }
+    }
+    return s.str();
+}
+
 void RecFilter::compile_jit(string filename) {
     auto ptr = contents.get();
 
@@ -953,13 +1738,25 @@ void RecFilter::compile_jit(string filename) {
         finalize();
     }
 
+    instrument();
+
+    // each Func object has its own pipeline that holds the compiled code,
+    // the filter keeps the one it compiled and realizes through it
     Func F = as_func();
     if (!filename.empty()) {
-        // FIXME: Does this still emit HTML?
-        F.compile_to_lowered_stmt(filename, F.infer_arguments());
+        bool html = (filename.size()>5 && filename.substr(filename.size()-5)==".html");
+        F.compile_to_lowered_stmt(filename, F.infer_arguments(), (html ? HTML : Text), ptr->target);
     }
+
+    uint64_t time_start = nanosecond_timer();
     F.compile_jit(ptr->target);
+    ptr->metrics.compile_latency.record(nanosecond_timer()-time_start);
+    ptr->metrics.compile_count.fetch_add(1, std::memory_order_relaxed);
+
+    read_jit_symbols();
 
+    ptr->compiled_func      = F;
+    ptr->compiled_signature = pipeline_signature(F.function(), ptr->target);
     ptr->compiled = true;
 }
 
@@ -988,12 +1785,22 @@ Realization RecFilter::create_realization(void) {
             << ptr->name << endl;
     }
 
-    // recompile the filter
-    ptr->compiled = false;
-    compile_jit();
+    // reuse the compiled pipeline unless any function it computes has been
+    // redefined or rescheduled since, through this filter or directly
+    if (ptr->compiled) {
+        Func F(internal_function(ptr->name).func);
+        if (pipeline_signature(F.function(), ptr->target) != ptr->compiled_signature) {
+            ptr->compiled = false;
+        }
+    }
+    if (ptr->compiled) {
+        ptr->metrics.compile_cache_hits.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        compile_jit();
+    }
 
     // upload all buffers to device if computed on GPU
-    Func F(internal_function(ptr->name).func);
+    Func F = ptr->compiled_func;
     if (ptr->target.has_gpu_feature()) {
         // FIXME: Do we really need to copy buffers manually here?
     }
@@ -1001,13 +1808,14 @@ Realization RecFilter::create_realization(void) {
     // allocate the buffer
     vector<int> buffer_size;
     for (int i=0; i<ptr->filter_info.size(); i++) {
-        buffer_size.push_back(ptr->filter_info[i].image_width);
+        buffer_size.push_back((ptr->filter_info[i].image_width-2*ptr->filter_info[i].border_margin) /
+                ptr->filter_info[i].output_stride);
     }
 
     // create a realization object
     vector<Buffer<>> buffers;
     for (int i=0; i<F.outputs(); i++) {
-        buffers.push_back(Buffer<>(ptr->type, buffer_size));
+        buffers.push_back(Buffer<>(F.output_types()[i], buffer_size));
     }
 
     return Realization(buffers);
@@ -1016,38 +1824,64 @@ Realization RecFilter::create_realization(void) {
 Realization RecFilter::realize(void) {
     auto ptr = contents.get();
 
-    Func F(internal_function(ptr->name).func);
     Realization R = create_realization();
+    Func F = ptr->compiled_func;
+
+    start_profiling(F);
+    uint64_t time_start = nanosecond_timer();
     F.realize(R, ptr->target);
+    record_realization(nanosecond_timer()-time_start);
+    stop_profiling();
+
     return R;
 }
 
+void RecFilter::record_realization(uint64_t ns) {
+    auto ptr = contents.get();
+
+    uint64_t pixels = 1;
+    for (int i=0; i<ptr->filter_info.size(); i++) {
+        pixels *= (ptr->filter_info[i].image_width-2*ptr->filter_info[i].border_margin) / ptr->filter_info[i].output_stride;
+    }
+    ptr->metrics.realize_count.fetch_add(1, std::memory_order_relaxed);
+    ptr->metrics.pixels.fetch_add(pixels, std::memory_order_relaxed);
+    ptr->metrics.execute_latency.record(ns);
+}
+
 float RecFilter::profile(int iterations) {
     auto ptr = contents.get();
 
-    Func F(internal_function(ptr->name).func);
     Realization R = create_realization();
+    Func F = ptr->compiled_func;
 
     double total_time = 0;
     unsigned long time_start, time_end;
 
+    start_profiling(F);
+
     if (ptr->target.has_gpu_feature()) {
         F.realize(R, ptr->target); // warmup run
 
         time_start = millisecond_timer();
         for (int i=0; i<iterations; i++) {
+            uint64_t t = nanosecond_timer();
             F.realize(R, ptr->target);
+            record_realization(nanosecond_timer()-t);
         }
         time_end = millisecond_timer();
     } else {
         time_start = millisecond_timer();
         for (int i=0; i<iterations; i++) {
+            uint64_t t = nanosecond_timer();
             F.realize(R, ptr->target);
+            record_realization(nanosecond_timer()-t);
         }
         time_end = millisecond_timer();
     }
     total_time = (time_end-time_start);
 
+    stop_profiling();
+
     return total_time/iterations;
 }
 
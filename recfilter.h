@@ -7,6 +7,8 @@
 #include <stdexcept>
 #include <cstdio>
 #include <algorithm>
+#include <cstdint>
+#include <complex>
 
 #include <Halide.h>
 
@@ -140,6 +142,104 @@ RecFilterDimAndCausality operator-(RecFilterDim x);
 // @}
 
 
+// ----------------------------------------------------------------------------
+
+/** Address range of JIT compiled code that computes a function of the recursive
+ * filter; used to attribute samples of external or in-process profilers to
+ * the functions of the filter */
+struct RecFilterSymbol {
+    std::string symbol;     ///< name of the compiled function, e.g. a parallel loop body
+    std::string name;       ///< name of the function computed by the code
+    std::string func_tag;   ///< function tag, e.g. INTRA_N, INTER or REINDEX
+    uint64_t    address;    ///< start address of the code
+    uint64_t    size;       ///< size of the code in bytes
+};
+
+/** Hardware counter totals of a function of the recursive filter, excluding
+ * functions computed inside it */
+struct RecFilterCounters {
+    std::string name;       ///< name of the function
+    std::string func_tag;   ///< function tag, e.g. INTRA_N, INTER or REINDEX
+    uint64_t    calls;      ///< number of productions and parallel loop iterations
+
+    /** Value of each counter that could be opened: cycles, instructions,
+     * L1D_misses, L2_misses, LLC_misses, DTLB_misses and FP_ops */
+    std::map<std::string, uint64_t> counters;
+
+    /** Fraction of the time the counters were counting; it is less than 1 if
+     * the kernel multiplexed them with other events, in which case the counts
+     * are estimates scaled up by its inverse */
+    double      running;
+
+    /** Productions and loop iterations during which the counters never ran;
+     * they are not included in the counts */
+    uint64_t    unmeasured;
+};
+
+/** Per thread busy time of a parallel loop of the recursive filter; the loop
+ * is identified by its JIT compiled loop body */
+struct RecFilterLoadBalance {
+    std::string name;       ///< name of the function computed by the loop
+    std::string func_tag;   ///< function tag, e.g. INTRA_N, INTER or REINDEX
+    int         iterations; ///< number of loop iterations
+    int         threads;    ///< number of threads that ran at least one iteration
+    double      wall_ms;    ///< time during which at least one iteration was running
+    double      busy_ms;    ///< total time spent in iterations by all threads
+    std::vector<double> thread_busy_ms; ///< time spent in iterations by each thread
+
+    /** Busiest thread over mean thread busy time, 1 if perfectly balanced */
+    double imbalance;
+
+    /** Busy time over wall time times number of threads */
+    double utilization;
+};
+
+/** Number of subnormal floating point values stored by a function of the
+ * recursive filter */
+struct RecFilterDenormals {
+    std::string name;       ///< name of the function
+    std::string func_tag;   ///< function tag, e.g. INTRA_N, INTER or REINDEX
+    uint64_t    stores;     ///< number of floating point values stored
+    uint64_t    denormals;  ///< number of subnormal values stored
+};
+
+/** Loop in the final loop nest of a definition */
+struct RecFilterLoop {
+    std::string var;        ///< loop variable
+    std::string type;       ///< Serial, Parallel, Vectorized, Unrolled, GPUBlock or GPUThread
+    int64_t     extent;     ///< constant extent or vector width of the loop, 0 if unknown
+};
+
+/** Final loop nest and storage of a definition of a recursive filter function */
+struct RecFilterLoopNest {
+    std::string name;           ///< name of the function
+    std::string func_tag;       ///< function tag, e.g. INTRA_N, INTER or REINDEX
+    std::string compute_level;  ///< inline, root or the loop level where it is computed
+    int         definition;     ///< update definition id, -1 for pure definition
+    int64_t     storage_bytes;  ///< bytes allocated for the function, -1 if unknown or inlined
+    bool        scan;           ///< true if the definition is a scan
+    bool        scan_select;    ///< true if the scan carries select statements
+    bool        scan_clamp;     ///< true if the scan carries clamps (min or max)
+    std::vector<RecFilterLoop> loops; ///< loops listed from outermost to innermost
+};
+
+/** Snapshot of the counters and latency histograms of a recursive filter;
+ * bucket i of a histogram counts latencies less than 2^i microseconds that did
+ * not fit in bucket i-1, the last bucket counts everything larger */
+struct RecFilterMetrics {
+    std::string name;                       ///< name of the filter
+    uint64_t    realize_count;              ///< number of realizations
+    uint64_t    pixels;                     ///< number of output pixels produced
+    uint64_t    compile_count;              ///< number of JIT compilations
+    uint64_t    compile_cache_hits;         ///< realizations that reused the compiled pipeline
+    std::vector<uint64_t> compile_latency;  ///< histogram of JIT compilation latency
+    uint64_t    compile_latency_count;      ///< number of samples in compile latency histogram
+    double      compile_latency_sum_ms;     ///< sum of samples in compile latency histogram
+    std::vector<uint64_t> execute_latency;  ///< histogram of realization latency excluding compilation
+    uint64_t    execute_latency_count;      ///< number of samples in execute latency histogram
+    double      execute_latency_sum_ms;     ///< sum of samples in execute latency histogram
+};
+
 // ----------------------------------------------------------------------------
 
 /** Recursive filter class */
@@ -182,6 +282,41 @@ private:
      */
     Halide::Realization create_realization(void);
 
+    /** Check if any profiling or tracing instrumentation has been enabled */
+    bool instrumented(void) const;
+
+    /** Mark all functions which are not inlined for tracing if any
+     * instrumentation is enabled, must be called before compilation */
+    void instrument(void);
+
+    /** Install the profiling hooks in the function being realized
+     * \param F output function of the filter
+     */
+    void start_profiling(Halide::Func F);
+
+    /** Detach the profiling hooks after realization and flush collected data */
+    void stop_profiling(void);
+
+    /** Read the functions of the pipeline that was just compiled from the
+     * object the JIT registered with the debugger interface and append them to
+     * the perf map if enabled; must be called right after JIT compilation */
+    void read_jit_symbols(void);
+
+    /** Apply a causal or anticausal FIR filter to the initial definition if it
+     * commutes with all scans added so far, otherwise to the output of all
+     * scans in the output function created by tiling; taps are recorded in
+     * the filter info of the dimension so that adjoints can transpose them
+     * \param x filter dimension and causality
+     * \param weights one matrix per tap mixing the outputs of the filter, element
+     * (i,j) of tap k at index i*outputs+j weights output j at distance k for output i
+     */
+    void add_feedforward_taps(RecFilterDimAndCausality x, std::vector<std::vector<float> > weights);
+
+    /** Update realization counters and latency histogram
+     * \param ns execution time of the realization in nanoseconds
+     */
+    void record_realization(uint64_t ns);
+
 public:
 
     /** Empty constructor */
@@ -247,11 +382,14 @@ public:
      * filters, but it must be called by the application for non-tiled filters */
     void apply_bounds(void);
 
-    /** Trigger JIT compilation for specified hardware-platform target; dumps the generated
-     * codegen in human readable HTML format if filename is specified */
+    /** Trigger JIT compilation for specified hardware-platform target; dumps the lowered
+     * statement if filename is specified, in HTML format if the filename ends with .html
+     * and as plain text otherwise */
     void compile_jit(std::string filename="");
 
-    /** Compute the filter
+    /** Compute the filter; the pipeline compiled by the last compilation is
+     * reused as long as the definitions and schedules of all functions it
+     * computes are unchanged, otherwise the filter is recompiled
      * \returns Realization object that contains all the buffers
      */
     Halide::Realization realize(void);
@@ -263,6 +401,126 @@ public:
     float profile(int iterations);
     // @}
 
+    /**@name Profiling and instrumentation
+     * Tracing, hardware counters, load balance statistics and denormal
+     * detection install hooks that reach the filter through one process wide
+     * slot: only one instrumented realization may run at a time and starting a
+     * second one concurrently, of any filter, fails
+     */
+    // {@
+
+    /** Append an entry to /tmp/perf-<pid>.map for every function of the JIT
+     * compiled pipeline, including serial code and parallel loop bodies, each
+     * named after the compiled function and tagged with the filter function it
+     * computes; Linux perf then attributes samples to these functions. Entries
+     * are written on every compilation and do not require tracing. Addresses
+     * and sizes are those of the symbol table that LLVM's MCJIT registers with
+     * the GDB JIT interface; nothing is written, with a warning, if the JIT
+     * did not register its code */
+    void enable_perf_map(void);
+
+    /** Address ranges of the functions of the last compiled pipeline, read from
+     * the symbol table the JIT registered for debuggers; useful for in-process
+     * samplers
+     * \returns list of symbols sorted by address, empty if the filter is not
+     * compiled or the JIT did not register its code
+     */
+    std::vector<RecFilterSymbol> jit_symbols(void) const;
+
+    /** Record the begin and end of every function production and every parallel
+     * loop iteration in subsequent realizations; each thread writes to its own
+     * ring buffer so only the most recent events are kept if a buffer overflows
+     * \param events_per_thread capacity of the ring buffer of each thread
+     */
+    void enable_tracing(int events_per_thread=65536);
+
+    /** Export the events recorded in the last realization or profiling run in
+     * Chrome trace event format, viewable in chrome://tracing or Perfetto; events
+     * are annotated with function tags and the tile indices of the produced region
+     * \param filename JSON file to write
+     */
+    void export_chrome_trace(std::string filename) const;
+
+    /** Read Linux hardware performance counters around every function production
+     * and parallel loop iteration in subsequent realizations; L2 misses and FP
+     * operations have no portable event and are only counted if the processor
+     * specific raw event codes are given; the counters of each thread are
+     * opened as one group during a realization and closed after it
+     * \param raw_l2_event raw perf event code for L2 misses (optional)
+     * \param raw_fp_event raw perf event code for floating point operations (optional)
+     */
+    void enable_hardware_counters(uint64_t raw_l2_event=0, uint64_t raw_fp_event=0);
+
+    /** Hardware counters of each function collected in the last realization
+     * or profiling run, keyed by function name and function tag */
+    std::vector<RecFilterCounters> hardware_counters(void) const;
+
+    /** Print hardware counters of each function as a table */
+    std::string print_hardware_counters(void) const;
+
+    /** Record the busy time of every thread in every parallel loop in subsequent
+     * realizations, to find loops whose iterations do unequal work, e.g. border
+     * tiles, or that have fewer iterations than threads */
+    void enable_load_balance_stats(void);
+
+    /** Busy time, idle time and imbalance ratio of each parallel loop in the last
+     * realization or profiling run */
+    std::vector<RecFilterLoadBalance> load_balance(void) const;
+
+    /** Print load balance of each parallel loop as a table */
+    std::string print_load_balance(void) const;
+
+    /** Set flush to zero and denormals are zero floating point mode in the
+     * realizing thread and in every worker thread while it computes the filter,
+     * restoring each thread's mode afterwards; avoids the slow path of subnormal
+     * arithmetic in decaying IIR tails at the cost of tiny deviations. Without
+     * other instrumentation the mode is set by a stateless task hook, so such
+     * realizations may run concurrently with any other realization
+     * \param flush true to flush subnormal values to zero in subsequent realizations
+     */
+    void set_flush_denormals(bool flush=true);
+
+    /** Count subnormal values stored by every function in subsequent
+     * realizations; traces every store, so only meant for diagnosis */
+    void enable_denormal_detection(void);
+
+    /** Number of subnormal values stored by each function in the last
+     * realization or profiling run */
+    std::vector<RecFilterDenormals> denormal_counts(void) const;
+
+    /** Print subnormal value counts of each function as a table */
+    std::string print_denormal_counts(void) const;
+
+    /** Final loop nest of every definition of every function after scheduling,
+     * listing loop types and extents, vector widths, storage sizes and whether
+     * scans carry selects or clamps; useful to check that a schedule produced the
+     * intended code. Finalizes the filter and lowers it for the current target */
+    std::vector<RecFilterLoopNest> loop_report(void);
+
+    /** Print the loop nests returned by RecFilter::loop_report() */
+    std::string print_loop_report(void);
+    // @}
+
+    /**@name Metrics
+     * Counters and latency histograms maintained during the lifetime of the
+     * filter with relaxed atomic increments, always enabled
+     */
+    // {@
+
+    /** Snapshot of all counters and histograms */
+    RecFilterMetrics metrics(void) const;
+
+    /** Print all counters and histograms in Prometheus text exposition format */
+    std::string print_metrics(void) const;
+
+    /** Write all counters and histograms in Prometheus text exposition format to
+     * a file, e.g. for the textfile collector of node exporter; the file is
+     * replaced atomically
+     * \param filename file to write
+     */
+    void dump_metrics(std::string filename) const;
+    // @}
+
 
     /** @name Routines to add filters
      *
@@ -280,6 +538,153 @@ public:
     void add_filter(RecFilterDimAndCausality x, std::vector<float> coeff);
     // @}
 
+    /** @name Routines to add filters with multiple feedforward taps
+     *
+     *  @brief Add a causal or anticausal scan
+     *  y[n] = sum_k feedfwd[k]*x[n-k] + sum_j feedback[j]*y[n-j-1], e.g. sum-form
+     *  Deriche filters; the numerator is applied to the initial definition and
+     *  the scan has unit feedforward coeff, so no additional pass is required and
+     *  tiling treats it as an ordinary scan. After a scan of opposite causality
+     *  in the same dimension, e.g. an anticausal section following a causal one,
+     *  the numerator does not commute with that scan and is applied to the
+     *  output of all scans instead, by the output function created by tiling
+     *
+     * \param x filter dimension
+     * \param feedfwd feedforward coeff of taps 0,1,2...
+     * \param feedback feedback coeffs
+     *
+     * Preconditions if there is more than one feedforward tap:
+     * - image border must not be clamped
+     * - if a preceding scan in the same dimension has opposite causality, the
+     *   filter must be tiled and all later scans in that dimension must have
+     *   same causality
+     */
+    // {@
+    void add_arma_filter(RecFilterDim x, std::vector<float> feedfwd, std::vector<float> feedback);
+    void add_arma_filter(RecFilterDimAndCausality x, std::vector<float> feedfwd, std::vector<float> feedback);
+    // @}
+
+    /** @name Routines to add filters with matrix coefficients
+     *
+     *  @brief Add a causal or anticausal scan coupling the outputs of the filter
+     *  y[n] = B x[n] + sum_k A_k y[n-k-1], where x and y are the vectors of all
+     *  outputs, e.g. color filters that mix channels. Implemented as the matrix
+     *  FIR filter adj(I - sum_k A_k z^-k-1) B applied to the initial definition
+     *  followed by a scalar scan with the determinant as denominator, so that
+     *  tiling treats it as an ordinary scan; the scalar scan has order up to
+     *  outputs times the number of feedback matrices. The coupled modes share
+     *  this scalar scan, so repeated poles, e.g. identical uncoupled outputs,
+     *  and poles near the unit circle are sensitive to rounding its
+     *  coefficients to float: such recursions print a warning and are
+     *  rejected if the rounded scan diverges
+     *
+     * \param x filter dimension
+     * \param feedfwd feedforward matrix B, row major outputs x outputs
+     * \param feedback feedback matrices A_k, row major outputs x outputs
+     *
+     * Preconditions:
+     * - all poles of the recursion must lie inside the unit circle, also after
+     *   rounding the coefficients of the scalar scan to float
+     * - image border must not be clamped
+     * - if a preceding scan in the same dimension has opposite causality, the
+     *   filter must be tiled and all later scans in that dimension must have
+     *   same causality
+     */
+    // {@
+    void add_filter(RecFilterDim x, std::vector<float> feedfwd, std::vector<std::vector<float> > feedback);
+    void add_filter(RecFilterDimAndCausality x, std::vector<float> feedfwd, std::vector<std::vector<float> > feedback);
+    // @}
+
+    /** @brief Add a symmetric filter in sum form y = causal(x) + anticausal(x), e.g.
+     * sum-form Deriche filters; both branches read the same input and run as
+     * one causal scan over the outputs and their copies mirrored in x, so that
+     * the serial dependency in x is a single scan instead of a cascade of two;
+     * the output function mirrors the anticausal branch back and sums both
+     *
+     * \param x filter dimension
+     * \param causal_feedfwd feedforward coeffs of causal branch at x, x-1, x-2...
+     * \param anticausal_feedfwd feedforward coeffs of anticausal branch at x, x+1,
+     * x+2..., usually with zero first coeff so that x is counted once
+     * \param feedback feedback coeffs shared by both branches
+     *
+     * Preconditions:
+     * - no other scan may be added in the same dimension before or after
+     * - filter must be tiled
+     * - image border must not be clamped if there are multiple or different feedforward coeffs
+     * - no feedforward taps may be applied to the output of the filter
+     */
+    void add_symmetric_filter(
+            RecFilterDim x,
+            std::vector<float> causal_feedfwd,
+            std::vector<float> anticausal_feedfwd,
+            std::vector<float> feedback);
+
+    /** @name Routines to add complex filters
+     *
+     *  @brief Add a first order causal or anticausal complex scan
+     *  y[n] = feedfwd*x[n] + feedback*y[n-1], e.g. one term of a recursive Gabor
+     *  or Morlet filter; the outputs of the filter must be pairs of real and
+     *  imaginary parts. Implemented as a complex 2-tap feedforward filter applied
+     *  to the initial definition followed by a real second order scan with the
+     *  complex conjugate pole pair, so that tiling and vectorization treat real
+     *  and imaginary parts as ordinary outputs
+     *
+     * \param x filter dimension
+     * \param feedfwd complex feedforward coeff
+     * \param feedback complex feedback coeff (pole)
+     *
+     * Preconditions:
+     * - image border must not be clamped
+     * - if a preceding scan in the same dimension has opposite causality, the
+     *   filter must be tiled and all later scans in that dimension must have
+     *   same causality
+     */
+    // {@
+    void add_filter(RecFilterDim x, std::complex<float> feedfwd, std::complex<float> feedback);
+    void add_filter(RecFilterDimAndCausality x, std::complex<float> feedfwd, std::complex<float> feedback);
+    // @}
+
+    /** Store only every stride-th pixel of the output in a dimension, e.g. 2 to
+     * decimate after blurring for image pyramids; scans still run over all
+     * pixels but only the retained pixels are written to the output buffer,
+     * whose width becomes image width / stride. Requires the filter to be tiled;
+     * must be called before tiling
+     * \param x filter dimension
+     * \param stride output stride, must divide the image width and tile width
+     */
+    void set_output_stride(RecFilterDim x, int stride);
+
+    /** Normalized convolution of an image with missing pixels: the initial
+     * definition is multiplied by the validity mask and the mask is filtered
+     * as an additional output with the same scans; the output function
+     * created by tiling divides each output by the filtered mask, so both are
+     * filtered in one pass over memory. Outputs are zero where the filtered
+     * mask is not larger than min_weight. With a mirrored or periodic border
+     * the mask is extended over the margin like the image. Must be called
+     * after the initial definition and before adding scans; requires the
+     * filter to be tiled
+     * \param mask validity mask in terms of the filter dimensions, 1 for valid
+     * and 0 for missing pixels, or any non-negative confidence
+     * \param min_weight smallest filtered mask that is normalized
+     */
+    void set_normalized_convolution(Halide::Expr mask, float min_weight=1e-6f);
+
+    /** Convert the initial definition to the given type before filtering, e.g.
+     * to filter 8-bit images in floating point; the conversion is computed
+     * when each tile is loaded so no converted copy of the image is stored.
+     * Must be called before the filter is defined
+     * \param t type in which the filter is computed
+     */
+    void set_compute_type(Halide::Type t);
+
+    /** Store the output in a type different from the compute type; values are
+     * rounded and saturated if the output type is integer and the conversion
+     * is fused into the output store. Requires the filter to be tiled; must be
+     * called before tiling
+     * \param t type of the output buffer
+     */
+    void set_output_type(Halide::Type t);
+
     /** @name Buffer boundary conditions
      * Clamp image border to the last pixel in all boundaries, default border is 0
      */
@@ -287,6 +692,28 @@ public:
     void set_clamped_image_border(void);
     // @}
 
+    /** @name Mirrored and periodic boundary conditions
+     * Extend the image on both sides of every dimension with scans or
+     * feedforward taps by a margin that is filled by mirroring (with the edge
+     * pixel repeated) or by periodic wrapping of the image; dimensions without
+     * scans are not extended. The initial definition reads the extension by
+     * index arithmetic, so no padded copy of the image is stored. Scans run
+     * over the extended image and the output skips the margin. Must be called
+     * before the filter is defined; the filter must be tiled and in every
+     * extended dimension the image width plus twice the margin must be a
+     * multiple of the tile width.
+     *
+     * The extension is truncated at the margin, whose effect on the image
+     * decays as r^margin for the largest pole magnitude r of the scans; a
+     * relative error eps therefore needs margin >= log(eps)/log(r), e.g. 66
+     * pixels for r=0.9 and eps=1e-3, or 44 pixels for r=0.9 and eps=1e-2.
+     * \param margin extension on each side of every dimension with scans
+     */
+    // {@
+    void set_mirrored_image_border(int margin);
+    void set_periodic_image_border(int margin);
+    // @}
+
     /** Cast the recfilter as a Halide::Func; this returns the function that holds
      * the final result of this filter; useful for extracting the result of this
      * function to use as input to other Halide Func
@@ -396,6 +823,33 @@ public:
     RecFilter overlap_to_higher_order_filter(RecFilter fA, std::string name="O");
     // @}
 
+    /** Create the adjoint of the filter, i.e. the filter that computes the
+     * gradient with respect to the initial definition from the gradient with
+     * respect to the output, for backpropagation. Scans are applied in reverse
+     * order with flipped causality and the same coeff, and the adjoint is tiled
+     * like this filter. Feedforward taps are transposed the same way with
+     * transposed matrices mixing the outputs: taps applied to the output of
+     * this filter are applied to the initial definition of the adjoint, taps
+     * applied to the initial definition are applied after all adjoint scans;
+     * if those do not commute with the adjoint scans, e.g. for a causal ARMA
+     * filter followed by an anticausal scan, they are applied to the output
+     * of the adjoint, which must then be tiled. With a clamped image border
+     * each adjoint scan adds the gradient of the pixels read beyond the border
+     * back onto the edge pixel; such adjoints cannot be tiled and are returned
+     * untiled. The adjoint of a linear filter does not depend upon the input,
+     * so no intermediate result of this filter is needed.
+     *
+     * Preconditions:
+     * - output must not be strided
+     * - filter must not be a normalized convolution
+     *
+     * \param gradient gradient with respect to the output of this filter
+     * \param name name of the adjoint filter (optional)
+     *
+     * \returns adjoint filter
+     */
+    RecFilter adjoint(Halide::Func gradient, std::string name="");
+
     /**@name Collective scheduling handles */
     // {@
 
@@ -493,6 +947,17 @@ public:
     std::string print_hl_code  (void) const;
     // @}
 
+    /**@name Export the dependency graph of the finalized filter
+     * Nodes carry the function tag, compute level, estimated buffer size and
+     * arithmetic operations, and the measured time if tracing was enabled for
+     * the last realization; edges carry the estimated bytes read by the consumer.
+     * Flops of functions computed inside other functions are per instance.
+     */
+    // {@
+    std::string print_graph_dot (void); ///< Graphviz format
+    std::string print_graph_json(void); ///< JSON format
+    // @}
+
     /**@name Global constants for scheduling */
     // {@
 
@@ -5,17 +5,31 @@
 #include <string>
 #include <Halide.h>
 
+#include "profiling.h"
+
+/** Feedforward taps of a filter in a particular dimension */
+struct FeedforwardTaps {
+    int                  id;            ///< order in which taps were added over all dimensions
+    bool                 causal;        ///< taps read pixels before or after the current pixel
+    bool                 output;        ///< applied to the output of all scans instead of the initial definition
+    std::vector<std::vector<float> > weights; ///< one matrix per tap mixing the outputs, row major
+};
+
 /** Info about scans in a particular dimension */
 struct FilterInfo {
     int                  filter_order;  ///< order of recursive filter in a given dimension
     int                  filter_dim;    ///< dimension id
     int                  num_scans;     ///< number of scans in the dimension that must be tiled
-    int                  image_width;   ///< image width in this dimension
+    int                  image_width;   ///< image width in this dimension, including the border margin
+    int                  border_margin; ///< mirrored or periodic extension on each side, added by the first scan or taps in this dimension
     int                  tile_width;    ///< tile width in this dimension
+    int                  output_stride; ///< only every output_stride-th output pixel is stored
+    int                  branch_outputs;///< outputs before the mirrored anticausal branch of a symmetric filter was added, 0 if none
     Halide::Var          var;           ///< variable that represents this dimension
     Halide::RDom         rdom;          ///< RDom update domain of each scan
     std::vector<bool>    scan_causal;   ///< causal or anticausal flag for each scan
     std::vector<int>     scan_id;       ///< scan or update definition id of each scan
+    std::vector<FeedforwardTaps> feedfwd_taps; ///< feedforward taps in the order they were added
 };
 
 // ----------------------------------------------------------------------------
@@ -156,6 +170,19 @@ struct RecFilterContents {
     /** Buffer border expression */
     bool clamped_border;
 
+    /** Flag to indicate that scans add the pixels they read beyond the image
+     * border back onto the edge pixel, the transpose of a clamped border in
+     * adjoints of filters with clamped border */
+    bool transposed_clamped_border;
+
+    /** Number of pixels added on both sides of each dimension with scans or
+     * feedforward taps and filled by mirroring or periodically extending the
+     * image, 0 for zero or clamped border */
+    int border_margin;
+
+    /** Flag to indicate if the margin is a periodic instead of mirrored extension */
+    bool periodic_border;
+
     /** Name of recursive filter as well as function that contains the
      * definition of the filter  */
     std::string name;
@@ -163,6 +190,22 @@ struct RecFilterContents {
     /** Filter output type */
     Halide::Type type;
 
+    /** Type to which the initial definition is converted, undefined to use
+     * the type of the initial definition */
+    Halide::Type compute_type;
+
+    /** Flag to indicate if the outputs are divided by the filtered validity
+     * mask stored as the last output of the filter */
+    bool normalized;
+
+    /** Smallest filtered mask for which normalized outputs are computed,
+     * outputs are zero where it is smaller */
+    float min_weight;
+
+    /** Type of the output buffer if different from the filter type, undefined
+     * otherwise; values are rounded and saturated when it is an integer type */
+    Halide::Type output_type;
+
     /** Info about all the scans in the recursive filter */
     std::vector<FilterInfo> filter_info;
 
@@ -177,6 +220,20 @@ struct RecFilterContents {
 
     /** Compilation and execution target */
     Halide::Target target;
+
+    /** Output function of the last JIT compilation, its pipeline holds the
+     * compiled code and is used by all realizations */
+    Halide::Func compiled_func;
+
+    /** Definitions and schedules of all functions of the last JIT compilation,
+     * the compiled pipeline is reused as long as they do not change */
+    std::string compiled_signature;
+
+    /** Instrumentation state for profilers and tracing */
+    ProfilingInfo profiling;
+
+    /** Realization and compilation counters */
+    MetricsInfo metrics;
 };
 
 #endif // _RECURSIVE_FILTER_INTERNALS_H_
@@ -34,6 +34,26 @@ vector<RecFilter> RecFilter::cascade(vector<vector<int> > scans) {
         assert(false);
     }
 
+    for (int i=0; i<ptr->filter_info.size(); i++) {
+        if (ptr->filter_info[i].branch_outputs || ptr->border_margin) {
+            cerr << "Cascading directive cascade() cannot be used for " << ptr->name
+                << " because it contains a symmetric filter or extended border" << endl;
+            assert(false);
+        }
+        for (int j=0; j<ptr->filter_info[i].feedfwd_taps.size(); j++) {
+            if (ptr->filter_info[i].feedfwd_taps[j].output) {
+                cerr << "Cascading directive cascade() cannot be used for " << ptr->name
+                    << " because feedforward taps are applied to its output" << endl;
+                assert(false);
+            }
+        }
+    }
+    if (ptr->transposed_clamped_border) {
+        cerr << "Cascading directive cascade() cannot be used for " << ptr->name
+            << " because it is the adjoint of a filter with clamped border" << endl;
+        assert(false);
+    }
+
     // check that the order does not violate
     {
         map<int, bool> scan_causal;
@@ -294,6 +314,27 @@ RecFilter RecFilter::overlap_to_higher_order_filter(RecFilter fB, string overlap
         assert(false);
     }
 
+    // adjoints of filters with clamped border are not ordinary scans
+    if (ptr->transposed_clamped_border || fB.contents.get()->transposed_clamped_border) {
+        cerr << "Filters cannot be overlapped because one of them is the adjoint "
+            << "of a filter with clamped border" << endl;
+        assert(false);
+    }
+
+    // taps applied to the output of a filter do not commute with its scans
+    RecFilterContents* filters[2] = { ptr, fB.contents.get() };
+    for (int f=0; f<2; f++) {
+        for (int i=0; i<filters[f]->filter_info.size(); i++) {
+            for (int j=0; j<filters[f]->filter_info[i].feedfwd_taps.size(); j++) {
+                if (filters[f]->filter_info[i].feedfwd_taps[j].output) {
+                    cerr << "Filters cannot be overlapped because feedforward taps are "
+                        << "applied to the output of one of them" << endl;
+                    assert(false);
+                }
+            }
+        }
+    }
+
     // check that both filters have same type
     if (ptr->type != fB.contents.get()->type) {
         cerr << "Filters cannot be overlapped because they have different types" << endl;
@@ -389,3 +430,191 @@ RecFilter RecFilter::overlap_to_higher_order_filter(RecFilter fB, string overlap
     }
     return AB;
 }
+
+// -----------------------------------------------------------------------------
+
+/** Transpose of feedforward taps with n outputs: matrices mixing the outputs
+ * are transposed, the taps are applied with opposite causality by the caller */
+static vector<vector<float> > transpose_taps(vector<vector<float> > weights, int n) {
+    vector<vector<float> > transposed(weights.size(), vector<float>(n*n, 0.0f));
+    for (int k=0; k<weights.size(); k++) {
+        for (int i=0; i<n; i++) {
+            for (int j=0; j<n; j++) {
+                transposed[k][j*n+i] = weights[k][i*n+j];
+            }
+        }
+    }
+    return transposed;
+}
+
+RecFilter RecFilter::adjoint(Func gradient, string adjoint_name) {
+    auto ptr = contents.get();
+
+    if (adjoint_name.empty()) {
+        adjoint_name = ptr->name + "_Adjoint";
+    }
+
+    // normalization divides by the filtered mask, which is not linear
+    if (ptr->normalized) {
+        cerr << "Cannot create adjoint of " << ptr->name << " because it "
+            << "is a normalized convolution" << endl;
+        assert(false);
+    }
+
+    vector<RecFilterDim> args;
+    for (int i=0; i<ptr->filter_info.size(); i++) {
+        if (ptr->filter_info[i].output_stride != 1) {
+            cerr << "Cannot create adjoint of " << ptr->name << " because it "
+                << "has strided output" << endl;
+            assert(false);
+        }
+        if (ptr->filter_info[i].branch_outputs) {
+            cerr << "Cannot create adjoint of " << ptr->name << " because it "
+                << "contains a symmetric filter" << endl;
+            assert(false);
+        }
+        if (ptr->border_margin) {
+            cerr << "Cannot create adjoint of " << ptr->name << " because it "
+                << "has a mirrored or periodic border" << endl;
+            assert(false);
+        }
+        args.push_back(RecFilterDim(
+                    ptr->filter_info[i].var.name(),
+                    ptr->filter_info[i].image_width));
+    }
+
+    // the pure def is the gradient of the output of this filter
+    RecFilter rf(adjoint_name);
+    {
+        vector<Expr> call_args;
+        vector<Expr> pure_values;
+        Function g = gradient.function();
+        for (int j=0; j<args.size(); j++) {
+            call_args.push_back(args[j]);
+        }
+        for (int j=0; j<g.outputs(); j++) {
+            pure_values.push_back(Call::make(g, call_args, j));
+        }
+        rf(args) = pure_values;
+    }
+
+    // dimension and index in filter info of each scan, ordered by scan id
+    map<int, std::pair<int,int> > scans;
+    for (int u=0; u<ptr->filter_info.size(); u++) {
+        for (int v=0; v<ptr->filter_info[u].num_scans; v++) {
+            scans[ptr->filter_info[u].scan_id[v]] = std::make_pair(u,v);
+        }
+    }
+
+    // dimension and index in filter info of each set of feedforward taps,
+    // ordered as they were added
+    map<int, std::pair<int,int> > taps;
+    for (int u=0; u<ptr->filter_info.size(); u++) {
+        for (int v=0; v<ptr->filter_info[u].feedfwd_taps.size(); v++) {
+            taps[ptr->filter_info[u].feedfwd_taps[v].id] = std::make_pair(u,v);
+        }
+    }
+    int n = gradient.function().outputs();
+
+    // transpose of a product of scans is the product of transposed scans in
+    // reverse order; transpose of a causal scan with zero border is the
+    // anticausal scan with same coeff and vice versa, same for feedforward
+    // taps with transposed matrices mixing the outputs; taps applied to the
+    // output of this filter are transposed first, to the initial definition
+    // of the adjoint, and taps applied to the initial definition last
+    map<int, std::pair<int,int> >::reverse_iterator t;
+    for (t=taps.rbegin(); t!=taps.rend(); t++) {
+        const FeedforwardTaps& w = ptr->filter_info[t->second.first].feedfwd_taps[t->second.second];
+        RecFilterDim x = args[t->second.first];
+        if (w.output) {
+            rf.add_feedforward_taps((w.causal ? -x : +x), transpose_taps(w.weights, n));
+        }
+    }
+
+    map<int, std::pair<int,int> >::reverse_iterator s;
+    for (s=scans.rbegin(); s!=scans.rend(); s++) {
+        int scan_id = s->first;
+        int dim     = s->second.first;
+        int idx     = s->second.second;
+
+        RecFilterDim x = args[dim];
+        bool causal    = ptr->filter_info[dim].scan_causal[idx];
+
+        // trailing zero feedback coeff of lower order scans are dropped
+        int order = ptr->feedback_coeff.height();
+        while (order>1 && ptr->feedback_coeff(scan_id,order-1)==0.0f) {
+            order--;
+        }
+
+        vector<float> coeff;
+        coeff.push_back(ptr->feedfwd_coeff(scan_id));
+        for (int u=0; u<order; u++) {
+            coeff.push_back(ptr->feedback_coeff(scan_id,u));
+        }
+
+        rf.add_filter((causal ? -x : +x), coeff);
+
+        // transpose of a clamped border: a causal scan with clamped border
+        // computes s*x[0] at the edge pixel, s = b0 + sum_j a_j, and reads y[0]
+        // instead of y[n-j-1] before the image; the transposed scan with zero
+        // border is exact except at the edge pixel, which becomes
+        // s/b0 * (b0*g[0] + sum_j a_j*(v[1] + ... + v[j+1])) for the gradient g
+        // and the transposed scan v; mirrored for anticausal scans
+        if (ptr->clamped_border) {
+            RecFilterContents* adj = rf.contents.get();
+
+            float b0 = coeff[0];
+            float sum = b0;
+            for (int u=1; u<coeff.size(); u++) {
+                sum += coeff[u];
+            }
+            if (b0 == 0.0f) {
+                cerr << "Cannot create adjoint of " << ptr->name << " because scan "
+                    << scan_id << " with clamped border has zero feedforward coeff" << endl;
+                assert(false);
+            }
+
+            Function   f   = rf.internal_function(adj->name).func;
+            Definition def = f.update(f.updates().size()-1);
+            RDom rx = adj->filter_info[dim].rdom;
+            int  w  = adj->filter_info[dim].image_width;
+
+            vector<Expr>& values = def.values();
+            for (int i=0; i<values.size(); i++) {
+                vector<Expr> call_args = def.args();
+                call_args[dim] = (causal ? 0 : w-1);
+                Expr edge = Cast::make(adj->type, b0) * Call::make(f, call_args, i);
+                for (int j=0; j+1<coeff.size(); j++) {
+                    for (int k=1; k<=std::min(j+1, w-1); k++) {
+                        call_args[dim] = (causal ? k : w-1-k);
+                        edge += Cast::make(adj->type, coeff[j+1]) * Call::make(f, call_args, i);
+                    }
+                }
+                values[i] = select(rx.x == w-1,
+                        Cast::make(adj->type, sum/b0) * edge, values[i]);
+            }
+            adj->transposed_clamped_border = true;
+        }
+    }
+
+    for (t=taps.rbegin(); t!=taps.rend(); t++) {
+        const FeedforwardTaps& w = ptr->filter_info[t->second.first].feedfwd_taps[t->second.second];
+        RecFilterDim x = args[t->second.first];
+        if (!w.output) {
+            rf.add_feedforward_taps((w.causal ? -x : +x), transpose_taps(w.weights, n));
+        }
+    }
+
+    // same tiling as this filter, the transposed clamped border cannot be tiled
+    if (ptr->tiled && !ptr->clamped_border) {
+        map<string,int> dim_tile;
+        for (int i=0; i<ptr->filter_info.size(); i++) {
+            if (ptr->filter_info[i].tile_width < ptr->filter_info[i].image_width) {
+                dim_tile[ptr->filter_info[i].var.name()] = ptr->filter_info[i].tile_width;
+            }
+        }
+        rf.split(dim_tile);
+    }
+
+    return rf;
+}
@@ -1867,6 +1867,11 @@ void RecFilter::split(map<string,int> dim_tile) {
         cerr << "Recursive filter cannot be tiled twice" << endl;
         assert(false);
     }
+    if (ptr->transposed_clamped_border) {
+        cerr << "Recursive filter " << ptr->name << " cannot be tiled because it is "
+            << "the adjoint of a filter with clamped image border" << endl;
+        assert(false);
+    }
 
     // clear global variables
     // TODO: remove the global vars and make them objects of the RecFilter class in some way
@@ -1931,6 +1936,13 @@ void RecFilter::split(map<string,int> dim_tile) {
                 continue;
             }
 
+            // each output tile must hold the same number of retained pixels
+            if (tile_width % ptr->filter_info[j].output_stride) {
+                cerr << "Tile width " << tile_width << " must be a multiple of the "
+                    << "output stride in dimension " << x << endl;
+                assert(false);
+            }
+
             SplitInfo s;
 
             // copy data from filter_info struct to split_info struct
@@ -2047,9 +2059,169 @@ void RecFilter::split(map<string,int> dim_tile) {
                 }
             }
         }
-        for (int i=0; i<F.outputs(); i++) {
-            Expr val = Call::make(F_final, call_args, i);
-            values.push_back(val);
+
+        // dimensions with a mirrored branch of a symmetric filter, each doubles
+        // the outputs of the final term
+        vector<int> branch_dims;
+        for (int j=0; j<ptr->filter_info.size(); j++) {
+            if (ptr->filter_info[j].branch_outputs) {
+                branch_dims.push_back(j);
+            }
+        }
+        int num_outputs = F.outputs() >> branch_dims.size();
+
+        // sum of all branches of the final term at given pixels of the extended
+        // image in each dimension, mirrored branches are read at the mirrored pixel
+        auto branch_sum = [&](vector<Expr> pos) {
+            vector<Expr> sum;
+            for (int i=0; i<num_outputs; i++) {
+                Expr val;
+                for (int b=0; b<(1<<branch_dims.size()); b++) {
+                    vector<Expr> branch_args = call_args;
+                    int value_index = i;
+                    for (int j=0; j<ptr->filter_info.size(); j++) {
+                        FilterInfo& s = ptr->filter_info[j];
+                        Expr p = pos[j];
+                        for (int k=0; k<branch_dims.size(); k++) {
+                            if (branch_dims[k]==j && (b & (1<<k))) {
+                                p = s.image_width-1-p;
+                                value_index += s.branch_outputs;
+                            }
+                        }
+                        for (int k=0; k<branch_args.size(); k++) {
+                            branch_args[k] = substitute(s.var.name(), p, branch_args[k]);
+                        }
+                    }
+                    Expr term = Call::make(F_final, branch_args, value_index);
+                    val = (val.defined() ? val+term : term);
+                }
+                sum.push_back(val);
+            }
+            return sum;
+        };
+
+        // strided output only reads the retained pixels of the final term,
+        // the final term still computes every pixel because scans need them;
+        // the border margin is skipped
+        vector<Expr> pos;
+        for (int j=0; j<ptr->filter_info.size(); j++) {
+            Var var    = ptr->filter_info[j].var;
+            int stride = ptr->filter_info[j].output_stride;
+            int margin = ptr->filter_info[j].border_margin;
+            pos.push_back(stride!=1 || margin ? var*stride+margin : Expr(var));
+        }
+
+        // feedforward taps applied to the output are combined into one kernel
+        // that maps offsets of the pixels read from the final term to matrices
+        // mixing the outputs; all taps in a dimension have same causality, so
+        // the pixels between the output pixel and the pixel read are in the
+        // image if the pixel read is
+        map<vector<int>, vector<float> > kernel;
+        {
+            vector<float> identity(num_outputs*num_outputs, 0.0f);
+            for (int i=0; i<num_outputs; i++) {
+                identity[i*num_outputs+i] = 1.0f;
+            }
+            kernel[vector<int>(ptr->filter_info.size(), 0)] = identity;
+        }
+        for (int id=0; ; id++) {
+            int dim = -1;
+            int idx = -1;
+            for (int j=0; dim<0 && j<ptr->filter_info.size(); j++) {
+                for (int k=0; k<ptr->filter_info[j].feedfwd_taps.size(); k++) {
+                    if (ptr->filter_info[j].feedfwd_taps[k].id == id) {
+                        dim = j;
+                        idx = k;
+                    }
+                }
+            }
+            if (dim < 0) {
+                break;
+            }
+
+            FeedforwardTaps taps = ptr->filter_info[dim].feedfwd_taps[idx];
+            if (!taps.output) {
+                continue;
+            }
+
+            int n = num_outputs;
+            map<vector<int>, vector<float> > next;
+            map<vector<int>, vector<float> >::iterator kit;
+            for (kit=kernel.begin(); kit!=kernel.end(); kit++) {
+                for (int k=0; k<taps.weights.size(); k++) {
+                    vector<int> offset = kit->first;
+                    offset[dim] += (taps.causal ? -k : k);
+                    if (next.find(offset) == next.end()) {
+                        next[offset] = vector<float>(n*n, 0.0f);
+                    }
+                    for (int i=0; i<n; i++) {
+                        for (int j=0; j<n; j++) {
+                            for (int l=0; l<n; l++) {
+                                next[offset][i*n+j] += taps.weights[k][i*n+l] * kit->second[l*n+j];
+                            }
+                        }
+                    }
+                }
+            }
+            kernel = next;
+        }
+
+        values.resize(num_outputs);
+        map<vector<int>, vector<float> >::iterator kit;
+        for (kit=kernel.begin(); kit!=kernel.end(); kit++) {
+            vector<Expr> p = pos;
+            Expr inside;
+            for (int j=0; j<p.size(); j++) {
+                int offset = kit->first[j];
+                int width  = ptr->filter_info[j].image_width;
+                if (offset) {
+                    Expr in_image = (pos[j]+offset>=0 && pos[j]+offset<width);
+                    inside = (inside.defined() ? inside && in_image : in_image);
+                    p[j]   = clamp(pos[j]+offset, 0, width-1);
+                }
+            }
+            vector<Expr> term = branch_sum(p);
+            for (int i=0; i<num_outputs; i++) {
+                for (int j=0; j<num_outputs; j++) {
+                    float w = kit->second[i*num_outputs+j];
+                    if (w == 0.0f) {
+                        continue;
+                    }
+                    Expr v = (inside.defined() ? select(inside, term[j], make_zero(ptr->type)) : term[j]);
+                    if (w != 1.0f) {
+                        v = Cast::make(ptr->type, w) * v;
+                    }
+                    values[i] = (values[i].defined() ? values[i]+v : v);
+                }
+            }
+        }
+        for (int i=0; i<num_outputs; i++) {
+            if (!values[i].defined()) {
+                values[i] = make_zero(ptr->type);
+            }
+        }
+
+        // normalized convolution divides by the filtered mask, which is the
+        // last output, where enough valid pixels contribute
+        if (ptr->normalized) {
+            Expr weight = values.back();
+            values.pop_back();
+            for (int i=0; i<values.size(); i++) {
+                values[i] = select(weight > Cast::make(ptr->type, ptr->min_weight),
+                        values[i] / weight, make_zero(ptr->type));
+            }
+        }
+
+        // conversion to the output type is fused into the store
+        Type t = ptr->output_type;
+        for (int i=0; t.bits()!=0 && t!=ptr->type && i<values.size(); i++) {
+            if (t.is_float()) {
+                values[i] = cast(t, values[i]);
+            } else if (ptr->type.is_float()) {
+                values[i] = saturating_cast(t, round(values[i]));
+            } else {
+                values[i] = saturating_cast(t, values[i]);
+            }
         }
         F = Function(F.name());
         rF.func = F;
@@ -2060,12 +2232,14 @@ void RecFilter::split(map<string,int> dim_tile) {
         rF.producer_func = F_final.name();
         rF.update_var_category.clear();
 
-        // split the tiled vars of the final term
+        // split the tiled vars of the final term, each tile of the output
+        // holds the retained pixels of a tile of the final term
         for (int i=0; i<recfilter_split_info.size(); i++) {
             Var var        = recfilter_split_info[i].var;
             Var inner_var  = recfilter_split_info[i].inner_var;
             Var outer_var  = recfilter_split_info[i].outer_var;
-            int tile_width = recfilter_split_info[i].tile_width;
+            int tile_width = recfilter_split_info[i].tile_width /
+                ptr->filter_info[recfilter_split_info[i].filter_dim].output_stride;
 
             Func(F).split(var, outer_var, inner_var, tile_width);
 
@@ -2135,7 +2309,7 @@ void RecFilter::apply_bounds(void) {
 
     for (int i=0; i<ptr->filter_info.size(); i++) {
         string x = ptr->filter_info[i].var.name();
-        int    w = ptr->filter_info[i].image_width;
+        int    w = (ptr->filter_info[i].image_width-2*ptr->filter_info[i].border_margin) / ptr->filter_info[i].output_stride;
 
         Func F = as_func();
         for (int j=0; j<F.args().size(); j++) {
@@ -2154,6 +2328,41 @@ void RecFilter::finalize(void) {
         return;
     }
 
+    // strided output and sums of symmetric filter branches are produced by
+    // the reindexing function created by tiling
+    for (int i=0; !ptr->tiled && i<ptr->filter_info.size(); i++) {
+        if (ptr->filter_info[i].output_stride != 1) {
+            cerr << "Output stride of " << ptr->name << " requires the filter to be tiled" << endl;
+            assert(false);
+        }
+        if (ptr->filter_info[i].branch_outputs) {
+            cerr << "Symmetric filter " << ptr->name << " requires the filter to be tiled" << endl;
+            assert(false);
+        }
+        if (ptr->border_margin) {
+            cerr << "Mirrored or periodic border of " << ptr->name << " requires the filter to be tiled" << endl;
+            assert(false);
+        }
+    }
+    if (!ptr->tiled && ptr->output_type.bits()!=0 && ptr->output_type!=ptr->type) {
+        cerr << "Output type of " << ptr->name << " different from the filter type "
+            << "requires the filter to be tiled" << endl;
+        assert(false);
+    }
+    for (int i=0; !ptr->tiled && i<ptr->filter_info.size(); i++) {
+        for (int j=0; j<ptr->filter_info[i].feedfwd_taps.size(); j++) {
+            if (ptr->filter_info[i].feedfwd_taps[j].output) {
+                cerr << "Feedforward taps of " << ptr->name << " after a scan of opposite "
+                    << "causality require the filter to be tiled" << endl;
+                assert(false);
+            }
+        }
+    }
+    if (!ptr->tiled && ptr->normalized) {
+        cerr << "Normalized convolution " << ptr->name << " requires the filter to be tiled" << endl;
+        assert(false);
+    }
+
     apply_bounds();
 
     map<string,RecFilterFunc>::iterator fit;
@@ -0,0 +1,139 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <Halide.h>
+
+#include "recfilter.h"
+
+using namespace Halide;
+
+using std::cerr;
+using std::endl;
+using std::vector;
+
+/** Scan of given coeff along the rows (dimension 0) or columns (dimension 1)
+ * of an image by direct evaluation in double; with a clamped border the scan
+ * reads the edge pixel of its input instead of the pixels before the image */
+static void direct_scan(
+        vector<double>& image,   // row major width x height
+        int width,
+        int height,
+        int dimension,
+        bool causal,
+        const vector<float>& coeff,
+        bool clamped)
+{
+    int n = (dimension==0 ? width : height);
+    int m = (dimension==0 ? height : width);
+    for (int j=0; j<m; j++) {
+        auto at = [&](int t) -> double& {
+            int i = (causal ? t : n-1-t);
+            return (dimension==0 ? image[j*width+i] : image[i*width+j]);
+        };
+        for (int t=0; t<n; t++) {
+            double v = coeff[0] * at(t);
+            for (int k=1; k<coeff.size(); k++) {
+                if (t-k >= 0) {
+                    v += coeff[k] * at(t-k);
+                } else if (clamped) {
+                    v += coeff[k] * at(0);
+                }
+            }
+            at(t) = v;
+        }
+    }
+}
+
+/** Check the adjoint against the transpose of the direct filter by the dot
+ * product test <F x, g> = <x, F^T g> for random x and g */
+static bool check_adjoint(Buffer<float> in, Buffer<float> grad, int tile_width, bool clamped) {
+    int width  = in.width();
+    int height = in.height();
+
+    vector<float> c1 = { 0.6f, 0.5f, -0.1f };
+    vector<float> c2 = { 0.7f, 0.3f };
+
+    RecFilterDim x("x", width);
+    RecFilterDim y("y", height);
+
+    RecFilter F("Forward");
+    if (clamped) {
+        F.set_clamped_image_border();
+    }
+    F(x, y) = in(x.var(), y.var());
+    F.add_filter(+x, c1);
+    F.add_filter(-x, c1);
+    F.add_filter(+y, c2);
+    F.add_filter(-y, c2);
+    if (tile_width < width) {
+        F.split(x, tile_width, y, tile_width);
+    }
+
+    Func G("Gradient");
+    G(x.var(), y.var()) = grad(x.var(), y.var());
+
+    RecFilter A = F.adjoint(G);
+    if (tile_width < width && !clamped) {
+        A.cpu_auto_schedule();
+    }
+    Buffer<float> adj = A.realize();
+
+    vector<double> fx(width*height);
+    for (int j=0; j<height; j++) {
+        for (int i=0; i<width; i++) {
+            fx[j*width+i] = in(i,j);
+        }
+    }
+    direct_scan(fx, width, height, 0, true,  c1, clamped);
+    direct_scan(fx, width, height, 0, false, c1, clamped);
+    direct_scan(fx, width, height, 1, true,  c2, clamped);
+    direct_scan(fx, width, height, 1, false, c2, clamped);
+
+    double lhs  = 0.0;
+    double rhs  = 0.0;
+    double norm = 0.0;
+    for (int j=0; j<height; j++) {
+        for (int i=0; i<width; i++) {
+            lhs  += fx[j*width+i] * grad(i,j);
+            rhs  += double(in(i,j)) * adj(i,j);
+            norm += std::abs(double(in(i,j)) * adj(i,j));
+        }
+    }
+
+    if (std::abs(lhs-rhs) > 1e-5*norm) {
+        cerr << "Adjoint with " << (clamped ? "clamped" : "zero") << " border and tile width "
+            << tile_width << " gives <x, A g> = " << rhs << " instead of <F x, g> = "
+            << lhs << endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int width  = 64;
+    int height = 64;
+
+    RecFilter::set_vectorization_width(8);
+
+    Buffer<float> in(width, height);
+    Buffer<float> grad(width, height);
+    for (int y=0; y<height; y++) {
+        for (int x=0; x<width; x++) {
+            in(x,y)   = float(rand()) / RAND_MAX - 0.5f;
+            grad(x,y) = float(rand()) / RAND_MAX - 0.5f;
+        }
+    }
+
+    bool success = true;
+
+    success &= check_adjoint(in, grad, width, false);
+    success &= check_adjoint(in, grad, 16,    false);
+    success &= check_adjoint(in, grad, width, true);
+
+    if (success) {
+        cerr << "Success!" << endl;
+        return EXIT_SUCCESS;
+    }
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,89 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <Halide.h>
+
+#include "builders.h"
+
+using namespace Halide;
+
+using std::cerr;
+using std::endl;
+using std::vector;
+
+/** Mean over the box of given radius around (x,y) clipped to the image by
+ * direct summation */
+template<typename T>
+static double direct_box_mean(Buffer<T> image, int x, int y, int radius) {
+    double sum  = 0.0;
+    int    area = 0;
+    for (int j=std::max(y-radius,0); j<=std::min(y+radius, image.height()-1); j++) {
+        for (int i=std::max(x-radius,0); i<=std::min(x+radius, image.width()-1); i++) {
+            sum += image(i,j);
+            area++;
+        }
+    }
+    return sum / area;
+}
+
+/** Compare the box filter builder with direct summation */
+template<typename T>
+static bool check_box_filter(Buffer<T> image, int radius, int tile_width, Type accum) {
+    int width  = image.width();
+    int height = image.height();
+
+    RecFilterDim x("x", width);
+    RecFilterDim y("y", height);
+
+    Func I("Image");
+    I(x.var(), y.var()) = image(x.var(), y.var());
+
+    Func B = box_filter(I, x, y, radius, tile_width, accum, "Box");
+    Buffer<float> out = B.realize({width, height});
+
+    for (int j=0; j<height; j++) {
+        for (int i=0; i<width; i++) {
+            double expected = direct_box_mean(image, i, j, radius);
+            if (std::abs(out(i,j)-expected) > 1e-5*std::max(1.0, std::abs(expected))) {
+                cerr << "Box filter of radius " << radius << " with tile width "
+                    << tile_width << " in " << accum << " at (" << i << "," << j
+                    << ") is " << out(i,j) << " instead of " << expected << endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int width  = 64;
+    int height = 48;
+
+    RecFilter::set_vectorization_width(8);
+
+    Buffer<int>   int_image(width, height);
+    Buffer<float> float_image(width, height);
+    for (int y=0; y<height; y++) {
+        for (int x=0; x<width; x++) {
+            int_image(x,y)   = rand() % 256;
+            float_image(x,y) = float(rand()) / RAND_MAX - 0.5f;
+        }
+    }
+
+    bool success = true;
+
+    // boxes inside a tile are fused, wider ones compute the table at root
+    int radius[] = { 0, 2, 7, 20 };
+    for (int r : radius) {
+        success &= check_box_filter(int_image,   r, 16, Int(64));
+        success &= check_box_filter(int_image,   r, 16, Float(64));
+        success &= check_box_filter(float_image, r, 16, Float(64));
+    }
+
+    if (success) {
+        cerr << "Success!" << endl;
+        return EXIT_SUCCESS;
+    }
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,135 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <Halide.h>
+
+#include "builders.h"
+#include "iir_coeff.h"
+
+using namespace Halide;
+
+using std::cerr;
+using std::endl;
+using std::vector;
+
+/** k centered box filters of odd width applied in both dimensions by direct
+ * summation; the image is extended with zeros by the support of the cascade
+ * and the intermediate results are kept over the whole extension */
+template<typename T>
+static vector<double> direct_box_cascade(Buffer<T> image, int box, int k) {
+    int width  = image.width();
+    int height = image.height();
+    int margin = k*box;
+    int ew     = width +2*margin;
+    int eh     = height+2*margin;
+    int half   = (box-1)/2;
+
+    vector<double> a(ew*eh, 0.0);
+    for (int y=0; y<height; y++) {
+        for (int x=0; x<width; x++) {
+            a[(y+margin)*ew + x+margin] = image(x,y);
+        }
+    }
+
+    for (int n=0; n<2*k; n++) {
+        bool along_x = (n<k);
+        vector<double> b(ew*eh, 0.0);
+        for (int y=0; y<eh; y++) {
+            for (int x=0; x<ew; x++) {
+                double sum = 0.0;
+                for (int i=-half; i<=half; i++) {
+                    int xi = (along_x ? x+i : x);
+                    int yi = (along_x ? y : y+i);
+                    if (xi>=0 && xi<ew && yi>=0 && yi<eh) {
+                        sum += a[yi*ew + xi];
+                    }
+                }
+                b[y*ew + x] = sum / box;
+            }
+        }
+        a = b;
+    }
+
+    vector<double> result(width*height);
+    for (int y=0; y<height; y++) {
+        for (int x=0; x<width; x++) {
+            result[y*width + x] = a[(y+margin)*ew + x+margin];
+        }
+    }
+    return result;
+}
+
+/** Compare the repeated box Gaussian with the iterated box filter */
+template<typename T>
+static bool check_box_gaussian(Buffer<T> image, float sigma, int k, int tile_width, Type accum) {
+    int width  = image.width();
+    int height = image.height();
+
+    RecFilterDim x("x", width);
+    RecFilterDim y("y", height);
+
+    Func I("Image");
+    I(x.var(), y.var()) = image(x.var(), y.var());
+
+    Func B = box_gaussian(I, x, y, sigma, k, tile_width, accum, "BoxGaussian");
+    Buffer<float> out = B.realize({width, height});
+
+    // same odd box width as the builder
+    int box = gaussian_box_filter(k, sigma);
+    box += (box%2 ? 0 : 1);
+
+    vector<double> ref = direct_box_cascade(image, box, k);
+
+    for (int j=0; j<height; j++) {
+        for (int i=0; i<width; i++) {
+            double expected = ref[j*width + i];
+            if (std::abs(out(i,j)-expected) > 1e-5*std::max(1.0, std::abs(expected))) {
+                cerr << "Box Gaussian with sigma " << sigma << " and " << k << " boxes "
+                    << "in " << accum << " at (" << i << "," << j << ") is "
+                    << out(i,j) << " instead of " << expected << endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int width  = 64;
+    int height = 48;
+
+    RecFilter::set_vectorization_width(8);
+
+    // 8-bit images keep the integral images of all k in the exact range of Int(64)
+    Buffer<uint8_t> int_image(width, height);
+    Buffer<float>   float_image(width, height);
+    for (int y=0; y<height; y++) {
+        for (int x=0; x<width; x++) {
+            int_image(x,y)   = uint8_t(rand() % 256);
+            float_image(x,y) = float(rand()) / RAND_MAX - 0.5f;
+        }
+    }
+
+    bool success = true;
+
+    // narrow stencils are fused into the output tiles, wide ones are not
+    float sigma[] = { 1.0f, 4.0f };
+    for (float s : sigma) {
+        for (int k=1; k<=4; k++) {
+            success &= check_box_gaussian(int_image, s, k, 16, Int(64));
+        }
+        for (int k=1; k<=3; k++) {
+            success &= check_box_gaussian(int_image, s, k, 16, Float(64));
+        }
+    }
+
+    // floating point images need a box wide enough to bound the rounding error
+    success &= check_box_gaussian(float_image, 4.0f, 3, 16, Float(64));
+
+    if (success) {
+        cerr << "Success!" << endl;
+        return EXIT_SUCCESS;
+    }
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,88 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <Halide.h>
+
+#include "builders.h"
+
+using namespace Halide;
+
+using std::cerr;
+using std::endl;
+using std::vector;
+
+/** Interpolate the image at integer positions, which must reproduce the image,
+ * and at positions shifted by a constant, which must match the unfused
+ * schedule */
+static bool check_bspline(Buffer<float> image, int degree, int tile_width) {
+    int width  = image.width();
+    int height = image.height();
+
+    RecFilterDim x("x", width);
+    RecFilterDim y("y", height);
+
+    Func I("Image");
+    I(x.var(), y.var()) = image(x.var(), y.var());
+
+    Expr u = x.var();
+    Expr v = y.var();
+
+    for (int fuse=0; fuse<2; fuse++) {
+        Func B = bspline_warp(I, x, y, u, v, degree, tile_width, fuse, "Identity");
+        Buffer<float> out = B.realize({width, height});
+
+        for (int j=0; j<height; j++) {
+            for (int i=0; i<width; i++) {
+                if (std::abs(out(i,j)-image(i,j)) > 1e-4f) {
+                    cerr << "B-spline of degree " << degree << (fuse ? " fused" : "")
+                        << " at (" << i << "," << j << ") is " << out(i,j)
+                        << " instead of " << image(i,j) << endl;
+                    return false;
+                }
+            }
+        }
+    }
+
+    Func S0 = bspline_warp(I, x, y, u+0.25f, v-0.5f, degree, tile_width, false, "Shift");
+    Func S1 = bspline_warp(I, x, y, u+0.25f, v-0.5f, degree, tile_width, true,  "ShiftFused");
+    Buffer<float> out0 = S0.realize({width, height});
+    Buffer<float> out1 = S1.realize({width, height});
+
+    for (int j=0; j<height; j++) {
+        for (int i=0; i<width; i++) {
+            if (std::abs(out0(i,j)-out1(i,j)) > 1e-4f) {
+                cerr << "Shifted B-spline of degree " << degree << " at (" << i << ","
+                    << j << ") is " << out1(i,j) << " fused and " << out0(i,j)
+                    << " unfused" << endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int width  = 64;
+    int height = 64;
+
+    RecFilter::set_vectorization_width(8);
+
+    Buffer<float> image(width, height);
+    for (int y=0; y<height; y++) {
+        for (int x=0; x<width; x++) {
+            image(x,y) = float(rand()) / RAND_MAX;
+        }
+    }
+
+    bool success = true;
+
+    success &= check_bspline(image, 3, 16);
+    success &= check_bspline(image, 5, 16);
+
+    if (success) {
+        cerr << "Success!" << endl;
+        return EXIT_SUCCESS;
+    }
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,133 @@
+#include <iostream>
+#include <vector>
+#include <complex>
+#include <cmath>
+#include <cstdlib>
+#include <Halide.h>
+
+#include "recfilter.h"
+
+using namespace Halide;
+
+using std::cerr;
+using std::endl;
+using std::vector;
+using std::complex;
+
+/** Complex scan y[n] = b x[n] + a y[n-1] along the rows (dimension 0) or
+ * columns (dimension 1) of a complex image by direct evaluation in double,
+ * with zero border */
+static void direct_complex_scan(
+        vector<complex<double> >& image,   // row major width x height
+        int width,
+        int height,
+        int dimension,
+        bool causal,
+        complex<float> b,
+        complex<float> a)
+{
+    int n = (dimension==0 ? width : height);
+    int m = (dimension==0 ? height : width);
+    for (int j=0; j<m; j++) {
+        complex<double> prev = 0.0;
+        for (int t=0; t<n; t++) {
+            int i = (causal ? t : n-1-t);
+            complex<double>& v = (dimension==0 ? image[j*width+i] : image[i*width+j]);
+            v = complex<double>(b) * v + complex<double>(a) * prev;
+            prev = v;
+        }
+    }
+}
+
+/** Compare complex scans, tiled or not, with the direct complex recursion */
+static bool check_complex_filter(
+        Buffer<float> re,
+        Buffer<float> im,
+        vector<int> dims,
+        vector<bool> causal,
+        int tile_width,
+        complex<float> b,
+        complex<float> a)
+{
+    int width  = re.width();
+    int height = re.height();
+
+    RecFilterDim x("x", width);
+    RecFilterDim y("y", height);
+    RecFilterDim xy[2] = { x, y };
+
+    RecFilter F("Complex");
+    F(x, y) = vector<Expr>{ re(x.var(), y.var()), im(x.var(), y.var()) };
+    for (int i=0; i<dims.size(); i++) {
+        F.add_filter(causal[i] ? +xy[dims[i]] : -xy[dims[i]], b, a);
+    }
+    if (tile_width < width) {
+        F.split(x, tile_width, y, tile_width);
+        F.cpu_auto_schedule();
+    }
+    Realization R = F.realize();
+    Buffer<float> out_re = R[0];
+    Buffer<float> out_im = R[1];
+
+    vector<complex<double> > ref(width*height);
+    for (int j=0; j<height; j++) {
+        for (int i=0; i<width; i++) {
+            ref[j*width+i] = complex<double>(re(i,j), im(i,j));
+        }
+    }
+    for (int i=0; i<dims.size(); i++) {
+        direct_complex_scan(ref, width, height, dims[i], causal[i], b, a);
+    }
+
+    double max_ref = 0.0;
+    for (int i=0; i<width*height; i++) {
+        max_ref = std::max(max_ref, std::abs(ref[i]));
+    }
+
+    for (int j=0; j<height; j++) {
+        for (int i=0; i<width; i++) {
+            complex<double> e = ref[j*width+i];
+            complex<double> o(out_re(i,j), out_im(i,j));
+            if (std::abs(o-e) > 1e-4*max_ref) {
+                cerr << dims.size() << " complex scans with tile width " << tile_width
+                    << " at (" << i << "," << j << ") are " << o << " instead of "
+                    << e << endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int width  = 64;
+    int height = 64;
+
+    RecFilter::set_vectorization_width(8);
+
+    Buffer<float> re(width, height);
+    Buffer<float> im(width, height);
+    for (int y=0; y<height; y++) {
+        for (int x=0; x<width; x++) {
+            re(x,y) = float(rand()) / RAND_MAX;
+            im(x,y) = float(rand()) / RAND_MAX;
+        }
+    }
+
+    // Gabor-like pole with radius 0.8 rotating by 0.5 radians per pixel
+    complex<float> a = std::polar(0.8f, 0.5f);
+    complex<float> b = complex<float>(1.0f, 0.0f) - a;
+
+    bool success = true;
+
+    success &= check_complex_filter(re, im, {0},    {true},        width, b, a);
+    success &= check_complex_filter(re, im, {0},    {false},       width, b, a);
+    success &= check_complex_filter(re, im, {0},    {true},        16,    b, a);
+    success &= check_complex_filter(re, im, {0, 1}, {true, false}, 16,    b, a);
+
+    if (success) {
+        cerr << "Success!" << endl;
+        return EXIT_SUCCESS;
+    }
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,107 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <Halide.h>
+
+#include "recfilter.h"
+
+using namespace Halide;
+
+using std::cerr;
+using std::endl;
+using std::vector;
+
+/** Number of subnormal values in a buffer */
+static int count_subnormals(Buffer<float> out) {
+    int count = 0;
+    for (int j=0; j<out.height(); j++) {
+        for (int i=0; i<out.width(); i++) {
+            count += (std::fpclassify(out(i,j)) == FP_SUBNORMAL);
+        }
+    }
+    return count;
+}
+
+/** Product of two values in the calling thread, subnormal unless the thread
+ * flushes subnormal values to zero */
+static float subnormal_product(void) {
+    volatile float a = 1e-30f;
+    volatile float b = 1e-10f;
+    return a*b;
+}
+
+/** Decaying tail of a first order scan from a tiny impulse passes through the
+ * subnormal range; check that subnormal values are stored and detected by
+ * default, are flushed to zero in flush mode, and that the mode of the
+ * realizing thread is restored afterwards */
+static bool check_denormals(int width, int height, int tile_width) {
+    Buffer<float> impulse(width, height);
+    impulse.fill(0.0f);
+    for (int y=0; y<height; y++) {
+        impulse(0, y) = 1e-30f;
+    }
+
+    RecFilterDim x("x", width);
+    RecFilterDim y("y", height);
+
+    bool ok = true;
+    for (int flush=0; flush<2; flush++) {
+        RecFilter F(flush ? "Flushed" : "Subnormal");
+        F(x, y) = impulse(x.var(), y.var());
+        F.add_filter(+x, {1.0f, 0.5f});
+        F.split(x, tile_width);
+        F.cpu_auto_schedule();
+        F.set_flush_denormals(flush);
+        if (!flush) {
+            F.enable_denormal_detection();
+        }
+        Buffer<float> out = F.realize();
+
+        int subnormals = count_subnormals(out);
+        if (flush && subnormals) {
+            cerr << "Output in flush mode has " << subnormals << " subnormal values" << endl;
+            ok = false;
+        }
+        if (!flush && !subnormals) {
+            cerr << "Output without flush mode has no subnormal values" << endl;
+            ok = false;
+        }
+        if (!flush) {
+            uint64_t detected = 0;
+            vector<RecFilterDenormals> counts = F.denormal_counts();
+            for (int i=0; i<counts.size(); i++) {
+                detected += counts[i].denormals;
+            }
+            if (detected == 0) {
+                cerr << "Denormal detection found no subnormal values" << endl
+                    << F.print_denormal_counts() << endl;
+                ok = false;
+            }
+        }
+        if (std::fpclassify(subnormal_product()) != FP_SUBNORMAL) {
+            cerr << "Floating point mode of the realizing thread was not restored "
+                << "after realization" << (flush ? " in flush mode" : "") << endl;
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    RecFilter::set_vectorization_width(8);
+
+    bool success = true;
+
+#if defined(__SSE__) || defined(_M_X64) || defined(__aarch64__)
+    success &= check_denormals(64, 8, 16);
+#else
+    cerr << "Warning: flush to zero mode is not supported on this target" << endl;
+#endif
+
+    if (success) {
+        cerr << "Success!" << endl;
+        return EXIT_SUCCESS;
+    }
+    return EXIT_FAILURE;
+}
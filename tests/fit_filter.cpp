@@ -0,0 +1,140 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <Halide.h>
+
+#include "recfilter.h"
+#include "iir_coeff.h"
+
+using namespace Halide;
+
+using std::cerr;
+using std::endl;
+using std::vector;
+
+/** Causal scan followed by anticausal scan with the same coeff applied to a
+ * signal by direct evaluation in double, with zero border */
+static vector<double> direct_causal_anticausal(vector<double> signal, const vector<float>& coeff) {
+    int n = signal.size();
+    for (int pass=0; pass<2; pass++) {
+        vector<double> out(n);
+        for (int t=0; t<n; t++) {
+            int i = (pass==0 ? t : n-1-t);
+            double v = coeff[0] * signal[i];
+            for (int k=1; k<coeff.size() && k<=t; k++) {
+                v += coeff[k] * out[pass==0 ? i-k : i+k];
+            }
+            out[i] = v;
+        }
+        signal = out;
+    }
+    return signal;
+}
+
+/** Fit a filter pair to the kernel and check the reported error against the
+ * impulse response of the filter realized by the tiled engine and against
+ * its direct evaluation */
+static bool check_fit(vector<float> kernel, int order, float max_error, vector<float>& coeff) {
+    int width  = 128;
+    int height = 8;
+    int center = width/2;
+    int m      = kernel.size()/2;
+
+    float error = 0.0f;
+    coeff = fit_recursive_filter(kernel, order, error);
+
+    if (coeff.size() != order+1) {
+        cerr << "Fit of order " << order << " returned " << coeff.size() << " coeff" << endl;
+        return false;
+    }
+    if (!(error <= max_error)) {
+        cerr << "Fit of order " << order << " to kernel of " << kernel.size()
+            << " taps has error " << error << " above " << max_error << endl;
+        return false;
+    }
+
+    // impulse response of the fitted pair by the tiled filter
+    Buffer<float> impulse(width, height);
+    impulse.fill(0.0f);
+    for (int y=0; y<height; y++) {
+        impulse(center, y) = 1.0f;
+    }
+
+    RecFilterDim x("x", width);
+    RecFilterDim y("y", height);
+
+    RecFilter F("Fitted");
+    F(x, y) = impulse(x.var(), y.var());
+    F.add_filter(+x, coeff);
+    F.add_filter(-x, coeff);
+    F.split(x, 16);
+    F.cpu_auto_schedule();
+    Buffer<float> out = F.realize();
+
+    vector<double> signal(width, 0.0);
+    signal[center] = 1.0;
+    vector<double> response = direct_causal_anticausal(signal, coeff);
+
+    for (int i=0; i<width; i++) {
+        if (std::abs(out(i,0)-response[i]) > 1e-5) {
+            cerr << "Impulse response of fit of order " << order << " at " << i << " is "
+                << out(i,0) << " instead of " << response[i] << endl;
+            return false;
+        }
+    }
+
+    // relative L2 error over twice the kernel support, as reported by the fit
+    double e = 0.0;
+    double norm = 0.0;
+    for (int i=-int(kernel.size()); i<=int(kernel.size()); i++) {
+        double target = (std::abs(i)<=m ? kernel[m+i] : 0.0);
+        e    += (response[center+i]-target) * (response[center+i]-target);
+        norm += target*target;
+    }
+    e = std::sqrt(e/norm);
+    if (std::abs(e-error) > 1e-3*std::max(1.0, double(error))) {
+        cerr << "Fit of order " << order << " reports error " << error
+            << " instead of " << e << endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    RecFilter::set_vectorization_width(8);
+
+    bool success = true;
+    vector<float> coeff;
+
+    // the kernel of a first order pair y = 0.5x + 0.5y[-1] is recovered exactly
+    vector<float> exponential(41);
+    for (int i=0; i<exponential.size(); i++) {
+        exponential[i] = std::pow(0.5f, std::abs(i-20)) / 3.0f;
+    }
+    success &= check_fit(exponential, 1, 1e-4f, coeff);
+    if (success && (std::abs(coeff[0]-0.5f) > 1e-3f || std::abs(coeff[1]-0.5f) > 1e-3f)) {
+        cerr << "Fit of exponential kernel gives coeff " << coeff[0] << ", "
+            << coeff[1] << " instead of 0.5, 0.5" << endl;
+        success = false;
+    }
+
+    // Gaussian kernel of sigma 4 with support 4 sigma
+    vector<float> gaussian(33);
+    float sum = 0.0f;
+    for (int i=0; i<gaussian.size(); i++) {
+        gaussian[i] = std::exp(-0.5f*(i-16)*(i-16)/16.0f);
+        sum += gaussian[i];
+    }
+    for (int i=0; i<gaussian.size(); i++) {
+        gaussian[i] /= sum;
+    }
+    success &= check_fit(gaussian, 1, 0.5f,  coeff);
+    success &= check_fit(gaussian, 3, 0.05f, coeff);
+
+    if (success) {
+        cerr << "Success!" << endl;
+        return EXIT_SUCCESS;
+    }
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,126 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <Halide.h>
+
+#include "builders.h"
+
+using namespace Halide;
+
+using std::cerr;
+using std::endl;
+using std::vector;
+
+/** Mean over the box of given radius around each pixel clipped to the image
+ * by direct summation */
+static vector<double> direct_box_mean(const vector<double>& image, int width, int height, int radius) {
+    vector<double> mean(width*height);
+    for (int y=0; y<height; y++) {
+        for (int x=0; x<width; x++) {
+            double sum  = 0.0;
+            int    area = 0;
+            for (int j=std::max(y-radius,0); j<=std::min(y+radius, height-1); j++) {
+                for (int i=std::max(x-radius,0); i<=std::min(x+radius, width-1); i++) {
+                    sum += image[j*width+i];
+                    area++;
+                }
+            }
+            mean[y*width+x] = sum / area;
+        }
+    }
+    return mean;
+}
+
+/** Compare the guided filter builder with the guided filter computed from
+ * direct box means; the linear coefficients are rounded to float like the
+ * intermediate image of the builder */
+template<typename T>
+static bool check_guided_filter(Buffer<T> guide, Buffer<T> input, int radius, float eps, int tile_width, Type accum) {
+    int width  = guide.width();
+    int height = guide.height();
+
+    RecFilterDim x("x", width);
+    RecFilterDim y("y", height);
+
+    Func I("Guide");
+    Func P("Input");
+    I(x.var(), y.var()) = guide(x.var(), y.var());
+    P(x.var(), y.var()) = input(x.var(), y.var());
+
+    Func Q = guided_filter(I, P, x, y, radius, eps, tile_width, accum, "Guided");
+    Buffer<float> out = Q.realize({width, height});
+
+    vector<double> g(width*height), p(width*height), gp(width*height), gg(width*height);
+    for (int j=0; j<height; j++) {
+        for (int i=0; i<width; i++) {
+            int k = j*width+i;
+            g[k]  = guide(i,j);
+            p[k]  = input(i,j);
+            gp[k] = g[k]*p[k];
+            gg[k] = g[k]*g[k];
+        }
+    }
+    vector<double> mean_g  = direct_box_mean(g,  width, height, radius);
+    vector<double> mean_p  = direct_box_mean(p,  width, height, radius);
+    vector<double> mean_gp = direct_box_mean(gp, width, height, radius);
+    vector<double> mean_gg = direct_box_mean(gg, width, height, radius);
+
+    vector<double> a(width*height), b(width*height);
+    for (int k=0; k<width*height; k++) {
+        double ak = (mean_gp[k] - mean_g[k]*mean_p[k]) / (mean_gg[k] - mean_g[k]*mean_g[k] + eps);
+        a[k] = float(ak);
+        b[k] = float(mean_p[k] - ak*mean_g[k]);
+    }
+    vector<double> mean_a = direct_box_mean(a, width, height, radius);
+    vector<double> mean_b = direct_box_mean(b, width, height, radius);
+
+    for (int j=0; j<height; j++) {
+        for (int i=0; i<width; i++) {
+            int k = j*width+i;
+            double expected = mean_a[k]*g[k] + mean_b[k];
+            if (std::abs(out(i,j)-expected) > 1e-4*std::max(1.0, std::abs(expected))) {
+                cerr << "Guided filter of radius " << radius << " in " << accum
+                    << " at (" << i << "," << j << ") is " << out(i,j)
+                    << " instead of " << expected << endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int width  = 64;
+    int height = 48;
+
+    RecFilter::set_vectorization_width(8);
+
+    // guide with an edge so that a varies over the image
+    Buffer<int>   int_guide(width, height);
+    Buffer<int>   int_input(width, height);
+    Buffer<float> float_guide(width, height);
+    Buffer<float> float_input(width, height);
+    for (int y=0; y<height; y++) {
+        for (int x=0; x<width; x++) {
+            int_guide(x,y)   = (x<width/2 ? 40 : 200) + rand() % 16;
+            int_input(x,y)   = rand() % 256;
+            float_guide(x,y) = int_guide(x,y) / 255.0f;
+            float_input(x,y) = int_input(x,y) / 255.0f;
+        }
+    }
+
+    bool success = true;
+
+    int radius[] = { 1, 4, 12 };
+    for (int r : radius) {
+        success &= check_guided_filter(int_guide,   int_input,   r, 100.0f, 16, Int(64));
+        success &= check_guided_filter(float_guide, float_input, r, 1e-3f,  16, Float(64));
+    }
+
+    if (success) {
+        cerr << "Success!" << endl;
+        return EXIT_SUCCESS;
+    }
+    return EXIT_FAILURE;
+}
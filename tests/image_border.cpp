@@ -0,0 +1,140 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <Halide.h>
+
+#include "recfilter.h"
+
+using namespace Halide;
+
+using std::cerr;
+using std::endl;
+using std::vector;
+
+/** Causal and anticausal first order scans along the rows, and optionally the
+ * columns, of an image by direct evaluation in double, with zero border */
+static void direct_filter(vector<double>& image, int width, int height, bool scan_y, const vector<float>& coeff) {
+    for (int d=0; d<(scan_y ? 2 : 1); d++) {
+        int n = (d==0 ? width : height);
+        int m = (d==0 ? height : width);
+        for (int j=0; j<m; j++) {
+            for (int c=0; c<2; c++) {
+                double prev = 0.0;
+                for (int t=0; t<n; t++) {
+                    int i = (c==0 ? t : n-1-t);
+                    double& v = (d==0 ? image[j*width+i] : image[i*width+j]);
+                    v = coeff[0]*v + coeff[1]*prev;
+                    prev = v;
+                }
+            }
+        }
+    }
+}
+
+/** Compare a filter with mirrored or periodic border with the direct filter
+ * of the image explicitly extended over the margin; only dimensions with
+ * scans are extended */
+static bool check_border(Buffer<float> image, int margin, bool periodic, bool scan_y, int tile_width) {
+    int width  = image.width();
+    int height = image.height();
+
+    vector<float> coeff = { 0.4f, 0.6f };
+
+    RecFilterDim x("x", width);
+    RecFilterDim y("y", height);
+
+    RecFilter F("Border");
+    if (periodic) {
+        F.set_periodic_image_border(margin);
+    } else {
+        F.set_mirrored_image_border(margin);
+    }
+    F(x, y) = image(x.var(), y.var());
+    F.add_filter(+x, coeff);
+    F.add_filter(-x, coeff);
+    if (scan_y) {
+        F.add_filter(+y, coeff);
+        F.add_filter(-y, coeff);
+        F.split(x, tile_width, y, tile_width);
+    } else {
+        F.split(x, tile_width);
+    }
+    F.cpu_auto_schedule();
+    Buffer<float> out = F.realize();
+
+    if (out.width() != width || out.height() != height) {
+        cerr << "Output with " << (periodic ? "periodic" : "mirrored") << " border is "
+            << out.width() << "x" << out.height() << " instead of "
+            << width << "x" << height << endl;
+        return false;
+    }
+
+    int mx = margin;
+    int my = (scan_y ? margin : 0);
+    int ew = width +2*mx;
+    int eh = height+2*my;
+    auto extend = [&](int i, int w) {
+        if (periodic) {
+            return ((i%w)+w)%w;
+        }
+        return (i<0 ? -1-i : (i>=w ? 2*w-1-i : i));
+    };
+    vector<double> ref(ew*eh);
+    for (int j=0; j<eh; j++) {
+        for (int i=0; i<ew; i++) {
+            ref[j*ew+i] = image(extend(i-mx, width), extend(j-my, height));
+        }
+    }
+    direct_filter(ref, ew, eh, scan_y, coeff);
+
+    for (int j=0; j<height; j++) {
+        for (int i=0; i<width; i++) {
+            double expected = ref[(j+my)*ew + i+mx];
+            if (std::abs(out(i,j)-expected) > 1e-4) {
+                cerr << (periodic ? "Periodic" : "Mirrored") << " border of margin " << margin
+                    << (scan_y ? "" : " with scans in x only") << " at (" << i << ","
+                    << j << ") is " << out(i,j) << " instead of " << expected << endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int width  = 64;
+    int height = 48;
+
+    RecFilter::set_vectorization_width(8);
+
+    Buffer<float> image(width, height);
+    for (int y=0; y<height; y++) {
+        for (int x=0; x<width; x++) {
+            image(x,y) = float(rand()) / RAND_MAX;
+        }
+    }
+
+    // the second dimension of the last case has no scans and is not a
+    // multiple of the tile width, so it must not be extended
+    Buffer<float> narrow(width, 40);
+    for (int y=0; y<40; y++) {
+        for (int x=0; x<width; x++) {
+            narrow(x,y) = image(x,y);
+        }
+    }
+
+    bool success = true;
+
+    success &= check_border(image,  8,  false, true,  16);
+    success &= check_border(image,  8,  true,  true,  16);
+    success &= check_border(image,  24, false, true,  16);
+    success &= check_border(narrow, 8,  false, false, 16);
+    success &= check_border(narrow, 8,  true,  false, 16);
+
+    if (success) {
+        cerr << "Success!" << endl;
+        return EXIT_SUCCESS;
+    }
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,87 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <Halide.h>
+
+#include "recfilter.h"
+
+using namespace Halide;
+
+using std::cerr;
+using std::endl;
+using std::vector;
+
+/** Realize a tiled filter with load balance statistics and check that every
+ * parallel loop has iterations, that the busy time is the sum of the busy
+ * times of the threads and fits in the wall time of all threads, and that the
+ * imbalance of the busiest thread is at least 1 */
+static bool check_load_balance(Buffer<float> image, int tile_width) {
+    int width  = image.width();
+    int height = image.height();
+
+    RecFilterDim x("x", width);
+    RecFilterDim y("y", height);
+
+    RecFilter F("Balance");
+    F(x, y) = image(x.var(), y.var());
+    F.add_filter(+x, {0.5f, 0.5f});
+    F.add_filter(-x, {0.5f, 0.5f});
+    F.add_filter(+y, {0.5f, 0.5f});
+    F.add_filter(-y, {0.5f, 0.5f});
+    F.split(x, tile_width, y, tile_width);
+    F.cpu_auto_schedule();
+    F.enable_load_balance_stats();
+    F.realize();
+
+    vector<RecFilterLoadBalance> loops = F.load_balance();
+    if (loops.empty()) {
+        cerr << "No parallel loops recorded" << endl;
+        return false;
+    }
+
+    for (int i=0; i<loops.size(); i++) {
+        const RecFilterLoadBalance& l = loops[i];
+
+        double sum = 0.0;
+        for (int j=0; j<l.thread_busy_ms.size(); j++) {
+            sum += l.thread_busy_ms[j];
+        }
+        double eps = 1e-9 * std::max(1.0, l.busy_ms);
+
+        bool ok = (l.iterations > 0 &&
+                l.threads <= int(l.thread_busy_ms.size()) &&
+                std::abs(sum - l.busy_ms) <= eps &&
+                l.busy_ms <= l.wall_ms*l.thread_busy_ms.size() + eps &&
+                l.utilization <= 1.0 + 1e-9 &&
+                l.imbalance >= 1.0 - 1e-9);
+        if (!ok) {
+            cerr << "Inconsistent load balance of loop " << i << endl
+                << F.print_load_balance() << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int width  = 256;
+    int height = 256;
+
+    RecFilter::set_vectorization_width(8);
+
+    Buffer<float> image(width, height);
+    for (int y=0; y<height; y++) {
+        for (int x=0; x<width; x++) {
+            image(x,y) = float(rand()) / RAND_MAX;
+        }
+    }
+
+    bool success = check_load_balance(image, 32);
+
+    if (success) {
+        cerr << "Success!" << endl;
+        return EXIT_SUCCESS;
+    }
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,82 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <Halide.h>
+
+#include "recfilter.h"
+
+using namespace Halide;
+
+using std::cerr;
+using std::endl;
+using std::string;
+using std::vector;
+
+/** Check the loop report of a tiled filter with the default CPU schedule: it
+ * must list scans, parallel loops and loops vectorized with the
+ * vectorization width, and every definition must carry a function tag */
+static bool check_loop_report(Buffer<float> image, int tile_width, int vector_width) {
+    int width  = image.width();
+    int height = image.height();
+
+    RecFilterDim x("x", width);
+    RecFilterDim y("y", height);
+
+    RecFilter F("Report");
+    F(x, y) = image(x.var(), y.var());
+    F.add_filter(+x, {0.5f, 0.5f});
+    F.add_filter(+y, {0.5f, 0.5f});
+    F.split(x, tile_width, y, tile_width);
+    F.cpu_auto_schedule();
+
+    vector<RecFilterLoopNest> report = F.loop_report();
+
+    bool found_scan       = false;
+    bool found_parallel   = false;
+    bool found_vectorized = false;
+    for (int i=0; i<report.size(); i++) {
+        const RecFilterLoopNest& n = report[i];
+        if (n.func_tag.empty()) {
+            cerr << "Definition " << n.definition << " of " << n.name
+                << " has no function tag" << endl;
+            return false;
+        }
+        found_scan |= n.scan;
+        for (int j=0; j<n.loops.size(); j++) {
+            found_parallel   |= (n.loops[j].type == "Parallel");
+            found_vectorized |= (n.loops[j].type == "Vectorized" && n.loops[j].extent == vector_width);
+        }
+    }
+
+    if (!found_scan || !found_parallel || !found_vectorized) {
+        cerr << "Loop report lacks " << (!found_scan ? "scans" : "")
+            << (!found_parallel ? " parallel loops" : "")
+            << (!found_vectorized ? " loops vectorized by the vectorization width" : "")
+            << endl << F.print_loop_report() << endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int width  = 64;
+    int height = 64;
+
+    RecFilter::set_vectorization_width(8);
+
+    Buffer<float> image(width, height);
+    for (int y=0; y<height; y++) {
+        for (int x=0; x<width; x++) {
+            image(x,y) = float(rand()) / RAND_MAX;
+        }
+    }
+
+    bool success = check_loop_report(image, 16, 8);
+
+    if (success) {
+        cerr << "Success!" << endl;
+        return EXIT_SUCCESS;
+    }
+    return EXIT_FAILURE;
+}
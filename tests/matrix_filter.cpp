@@ -0,0 +1,150 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <Halide.h>
+
+#include "recfilter.h"
+
+using namespace Halide;
+
+using std::cerr;
+using std::endl;
+using std::vector;
+
+/** Coupled recursion y[n] = B x[n] + sum_k A_k y[n-k-1] along each row of a
+ * two channel image by direct evaluation in double, with zero border */
+static void direct_matrix_scan(
+        vector<vector<double> >& image,   // channels, row major width x height
+        int width,
+        int height,
+        bool causal,
+        const vector<float>& B,
+        const vector<vector<float> >& A)
+{
+    int n = image.size();
+    for (int y=0; y<height; y++) {
+        vector<vector<double> > out(width, vector<double>(n, 0.0));
+        for (int t=0; t<width; t++) {
+            int x = (causal ? t : width-1-t);
+            for (int i=0; i<n; i++) {
+                double v = 0.0;
+                for (int j=0; j<n; j++) {
+                    v += B[i*n+j] * image[j][y*width+x];
+                }
+                for (int k=0; k<A.size() && k<t; k++) {
+                    for (int j=0; j<n; j++) {
+                        v += A[k][i*n+j] * out[t-k-1][j];
+                    }
+                }
+                out[t][i] = v;
+            }
+        }
+        for (int t=0; t<width; t++) {
+            int x = (causal ? t : width-1-t);
+            for (int i=0; i<n; i++) {
+                image[i][y*width+x] = out[t][i];
+            }
+        }
+    }
+}
+
+/** Compare matrix scans of a recursive filter, tiled or not, with the direct
+ * coupled recursion; a causal and an anticausal scan need tiling because
+ * their numerators are applied to the output */
+static bool check_matrix_filter(
+        Buffer<float> in0,
+        Buffer<float> in1,
+        vector<bool> causal,
+        int tile_width,
+        const vector<float>& B,
+        const vector<vector<float> >& A)
+{
+    int width  = in0.width();
+    int height = in0.height();
+
+    RecFilterDim x("x", width);
+    RecFilterDim y("y", height);
+
+    RecFilter F("Coupled");
+    F(x, y) = vector<Expr>{ in0(x.var(), y.var()), in1(x.var(), y.var()) };
+    for (int i=0; i<causal.size(); i++) {
+        F.add_filter(causal[i] ? +x : -x, B, A);
+    }
+    if (tile_width < width) {
+        F.split(x, tile_width);
+        F.cpu_auto_schedule();
+    }
+    Realization R = F.realize();
+    Buffer<float> out0 = R[0];
+    Buffer<float> out1 = R[1];
+
+    vector<vector<double> > ref(2, vector<double>(width*height));
+    for (int j=0; j<height; j++) {
+        for (int i=0; i<width; i++) {
+            ref[0][j*width+i] = in0(i,j);
+            ref[1][j*width+i] = in1(i,j);
+        }
+    }
+    for (int i=0; i<causal.size(); i++) {
+        direct_matrix_scan(ref, width, height, causal[i], B, A);
+    }
+
+    double max_ref = 0.0;
+    for (int c=0; c<2; c++) {
+        for (int i=0; i<width*height; i++) {
+            max_ref = std::max(max_ref, std::abs(ref[c][i]));
+        }
+    }
+
+    for (int j=0; j<height; j++) {
+        for (int i=0; i<width; i++) {
+            double e0 = ref[0][j*width+i];
+            double e1 = ref[1][j*width+i];
+            if (std::abs(out0(i,j)-e0) > 1e-4*max_ref || std::abs(out1(i,j)-e1) > 1e-4*max_ref) {
+                cerr << causal.size() << " matrix scans with tile width " << tile_width
+                    << " at (" << i << "," << j << ") are (" << out0(i,j) << ","
+                    << out1(i,j) << ") instead of (" << e0 << "," << e1 << ")" << endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int width  = 64;
+    int height = 8;
+
+    RecFilter::set_vectorization_width(8);
+
+    Buffer<float> in0(width, height);
+    Buffer<float> in1(width, height);
+    for (int y=0; y<height; y++) {
+        for (int x=0; x<width; x++) {
+            in0(x,y) = float(rand()) / RAND_MAX;
+            in1(x,y) = float(rand()) / RAND_MAX;
+        }
+    }
+
+    // second order coupled recursion with distinct poles inside the unit circle
+    vector<float> B = { 1.0f, 0.5f, -0.3f, 0.8f };
+    vector<vector<float> > A = {
+        { 0.5f, 0.2f, 0.1f,  0.4f  },
+        { 0.1f, 0.0f, 0.0f, -0.05f }
+    };
+
+    bool success = true;
+
+    success &= check_matrix_filter(in0, in1, {true},        width, B, A);
+    success &= check_matrix_filter(in0, in1, {false},       width, B, A);
+    success &= check_matrix_filter(in0, in1, {true},        16,    B, A);
+    success &= check_matrix_filter(in0, in1, {false},       16,    B, A);
+    success &= check_matrix_filter(in0, in1, {true, false}, 16,    B, A);
+
+    if (success) {
+        cerr << "Success!" << endl;
+        return EXIT_SUCCESS;
+    }
+    return EXIT_FAILURE;
+}
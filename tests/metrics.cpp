@@ -0,0 +1,93 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <Halide.h>
+
+#include "recfilter.h"
+
+using namespace Halide;
+
+using std::cerr;
+using std::endl;
+using std::string;
+using std::vector;
+
+/** Sum of the buckets of a latency histogram */
+static uint64_t histogram_total(const vector<uint64_t>& buckets) {
+    uint64_t total = 0;
+    for (int i=0; i<buckets.size(); i++) {
+        total += buckets[i];
+    }
+    return total;
+}
+
+/** Realize a filter repeatedly and check the counters, the histograms and
+ * the Prometheus text of its metrics */
+static bool check_metrics(Buffer<float> image, int realizations, int tile_width) {
+    int width  = image.width();
+    int height = image.height();
+
+    RecFilterDim x("x", width);
+    RecFilterDim y("y", height);
+
+    RecFilter F("Metrics");
+    F(x, y) = image(x.var(), y.var());
+    F.add_filter(+x, {0.5f, 0.5f});
+    F.add_filter(+y, {0.5f, 0.5f});
+    F.split(x, tile_width, y, tile_width);
+    F.cpu_auto_schedule();
+
+    for (int i=0; i<realizations; i++) {
+        F.realize();
+    }
+
+    RecFilterMetrics m = F.metrics();
+
+    bool ok = (m.name == "Metrics" &&
+            m.realize_count == realizations &&
+            m.pixels == uint64_t(realizations)*width*height &&
+            m.compile_count == 1 &&
+            m.compile_cache_hits == realizations-1 &&
+            m.compile_latency_count == 1 &&
+            m.execute_latency_count == realizations &&
+            histogram_total(m.compile_latency) == m.compile_latency_count &&
+            histogram_total(m.execute_latency) == m.execute_latency_count &&
+            m.compile_latency_sum_ms > 0.0 &&
+            m.execute_latency_sum_ms > 0.0);
+    if (!ok) {
+        cerr << "Metrics after " << realizations << " realizations are" << endl
+            << F.print_metrics() << endl;
+        return false;
+    }
+
+    string text = F.print_metrics();
+    if (text.find("recfilter_compile_cache_hits_total") == string::npos) {
+        cerr << "Prometheus text of metrics lacks the cache hit counter" << endl
+            << text << endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int width  = 64;
+    int height = 64;
+
+    RecFilter::set_vectorization_width(8);
+
+    Buffer<float> image(width, height);
+    for (int y=0; y<height; y++) {
+        for (int x=0; x<width; x++) {
+            image(x,y) = float(rand()) / RAND_MAX;
+        }
+    }
+
+    bool success = check_metrics(image, 5, 16);
+
+    if (success) {
+        cerr << "Success!" << endl;
+        return EXIT_SUCCESS;
+    }
+    return EXIT_FAILURE;
+}
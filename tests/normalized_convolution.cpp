@@ -0,0 +1,131 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <Halide.h>
+
+#include "recfilter.h"
+
+using namespace Halide;
+
+using std::cerr;
+using std::endl;
+using std::vector;
+
+/** Causal and anticausal first order scans along both dimensions of an image
+ * by direct evaluation in double, with zero border */
+static void direct_filter(vector<double>& image, int width, int height, const vector<float>& coeff) {
+    for (int d=0; d<2; d++) {
+        int n = (d==0 ? width : height);
+        int m = (d==0 ? height : width);
+        for (int j=0; j<m; j++) {
+            for (int c=0; c<2; c++) {
+                double prev = 0.0;
+                for (int t=0; t<n; t++) {
+                    int i = (c==0 ? t : n-1-t);
+                    double& v = (d==0 ? image[j*width+i] : image[i*width+j]);
+                    v = coeff[0]*v + coeff[1]*prev;
+                    prev = v;
+                }
+            }
+        }
+    }
+}
+
+/** Compare the normalized convolution with the ratio of the directly filtered
+ * masked image and the directly filtered mask; with a mirrored border both
+ * are extended by mirroring over the margin before filtering */
+static bool check_normalized_convolution(
+        Buffer<float> image,
+        Buffer<float> mask,
+        int tile_width,
+        int margin,
+        float min_weight)
+{
+    int width  = image.width();
+    int height = image.height();
+
+    vector<float> coeff = { 0.3f, 0.7f };
+
+    RecFilterDim x("x", width);
+    RecFilterDim y("y", height);
+
+    RecFilter F("Normalized");
+    if (margin) {
+        F.set_mirrored_image_border(margin);
+    }
+    F(x, y) = image(x.var(), y.var());
+    F.set_normalized_convolution(mask(x.var(), y.var()), min_weight);
+    F.add_filter(+x, coeff);
+    F.add_filter(-x, coeff);
+    F.add_filter(+y, coeff);
+    F.add_filter(-y, coeff);
+    F.split(x, tile_width, y, tile_width);
+    F.cpu_auto_schedule();
+    Buffer<float> out = F.realize();
+
+    // masked image and mask extended by mirroring with the edge pixel repeated
+    int ew = width +2*margin;
+    int eh = height+2*margin;
+    auto mirror = [](int i, int w) {
+        return (i<0 ? -1-i : (i>=w ? 2*w-1-i : i));
+    };
+    vector<double> num(ew*eh);
+    vector<double> den(ew*eh);
+    for (int j=0; j<eh; j++) {
+        for (int i=0; i<ew; i++) {
+            int u = mirror(i-margin, width);
+            int v = mirror(j-margin, height);
+            num[j*ew+i] = double(image(u,v)) * mask(u,v);
+            den[j*ew+i] = mask(u,v);
+        }
+    }
+    direct_filter(num, ew, eh, coeff);
+    direct_filter(den, ew, eh, coeff);
+
+    for (int j=0; j<height; j++) {
+        for (int i=0; i<width; i++) {
+            int k = (j+margin)*ew + i+margin;
+            double expected = (den[k] > min_weight ? num[k]/den[k] : 0.0);
+            if (std::abs(out(i,j)-expected) > 1e-4*std::max(1.0, std::abs(expected))) {
+                cerr << "Normalized convolution with margin " << margin << " at ("
+                    << i << "," << j << ") is " << out(i,j) << " instead of "
+                    << expected << endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int width  = 64;
+    int height = 64;
+
+    RecFilter::set_vectorization_width(8);
+
+    // about a third of the pixels are missing, including a 12x12 hole
+    Buffer<float> image(width, height);
+    Buffer<float> mask(width, height);
+    for (int y=0; y<height; y++) {
+        for (int x=0; x<width; x++) {
+            bool hole = (x>=20 && x<32 && y>=20 && y<32);
+            image(x,y) = float(rand()) / RAND_MAX;
+            mask(x,y)  = (hole || rand()%3==0 ? 0.0f : 1.0f);
+        }
+    }
+
+    bool success = true;
+
+    success &= check_normalized_convolution(image, mask, 16, 0, 1e-6f);
+    success &= check_normalized_convolution(image, mask, 16, 8, 1e-6f);
+
+    // pixels whose filtered mask is small are set to zero
+    success &= check_normalized_convolution(image, mask, 16, 0, 1e-2f);
+
+    if (success) {
+        cerr << "Success!" << endl;
+        return EXIT_SUCCESS;
+    }
+    return EXIT_FAILURE;
+}
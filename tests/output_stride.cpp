@@ -0,0 +1,120 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <Halide.h>
+
+#include "recfilter.h"
+
+using namespace Halide;
+
+using std::cerr;
+using std::endl;
+using std::vector;
+
+/** Causal and anticausal first order scans along both dimensions of an image
+ * by direct evaluation in double, with zero border */
+static void direct_filter(vector<double>& image, int width, int height, const vector<float>& coeff) {
+    for (int d=0; d<2; d++) {
+        int n = (d==0 ? width : height);
+        int m = (d==0 ? height : width);
+        for (int j=0; j<m; j++) {
+            for (int c=0; c<2; c++) {
+                double prev = 0.0;
+                for (int t=0; t<n; t++) {
+                    int i = (c==0 ? t : n-1-t);
+                    double& v = (d==0 ? image[j*width+i] : image[i*width+j]);
+                    v = coeff[0]*v + coeff[1]*prev;
+                    prev = v;
+                }
+            }
+        }
+    }
+}
+
+/** Compare strided output with every stride-th pixel of the direct filter;
+ * with a margin the image is extended by mirroring first */
+static bool check_stride(Buffer<float> image, int stride_x, int stride_y, int margin, int tile_width) {
+    int width  = image.width();
+    int height = image.height();
+
+    vector<float> coeff = { 0.4f, 0.6f };
+
+    RecFilterDim x("x", width);
+    RecFilterDim y("y", height);
+
+    RecFilter F("Strided");
+    if (margin) {
+        F.set_mirrored_image_border(margin);
+    }
+    F(x, y) = image(x.var(), y.var());
+    F.add_filter(+x, coeff);
+    F.add_filter(-x, coeff);
+    F.add_filter(+y, coeff);
+    F.add_filter(-y, coeff);
+    F.set_output_stride(x, stride_x);
+    F.set_output_stride(y, stride_y);
+    F.split(x, tile_width, y, tile_width);
+    F.cpu_auto_schedule();
+    Buffer<float> out = F.realize();
+
+    if (out.width() != width/stride_x || out.height() != height/stride_y) {
+        cerr << "Output with stride " << stride_x << "x" << stride_y << " is "
+            << out.width() << "x" << out.height() << " instead of "
+            << width/stride_x << "x" << height/stride_y << endl;
+        return false;
+    }
+
+    int ew = width +2*margin;
+    int eh = height+2*margin;
+    auto mirror = [](int i, int w) {
+        return (i<0 ? -1-i : (i>=w ? 2*w-1-i : i));
+    };
+    vector<double> ref(ew*eh);
+    for (int j=0; j<eh; j++) {
+        for (int i=0; i<ew; i++) {
+            ref[j*ew+i] = image(mirror(i-margin, width), mirror(j-margin, height));
+        }
+    }
+    direct_filter(ref, ew, eh, coeff);
+
+    for (int j=0; j<out.height(); j++) {
+        for (int i=0; i<out.width(); i++) {
+            double expected = ref[(j*stride_y+margin)*ew + i*stride_x+margin];
+            if (std::abs(out(i,j)-expected) > 1e-4) {
+                cerr << "Output with stride " << stride_x << "x" << stride_y
+                    << " and margin " << margin << " at (" << i << "," << j << ") is "
+                    << out(i,j) << " instead of " << expected << endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int width  = 64;
+    int height = 64;
+
+    RecFilter::set_vectorization_width(8);
+
+    Buffer<float> image(width, height);
+    for (int y=0; y<height; y++) {
+        for (int x=0; x<width; x++) {
+            image(x,y) = float(rand()) / RAND_MAX;
+        }
+    }
+
+    bool success = true;
+
+    success &= check_stride(image, 2, 1, 0, 16);
+    success &= check_stride(image, 2, 2, 0, 16);
+    success &= check_stride(image, 1, 4, 0, 16);
+    success &= check_stride(image, 2, 2, 8, 16);
+
+    if (success) {
+        cerr << "Success!" << endl;
+        return EXIT_SUCCESS;
+    }
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,132 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cstdio>
+#include <unistd.h>
+#include <Halide.h>
+
+#include "recfilter.h"
+
+using namespace Halide;
+
+using std::cerr;
+using std::endl;
+using std::string;
+using std::vector;
+
+/** Check that the JIT symbols of a compiled filter are disjoint address ranges
+ * of non-zero size, that they include the entry point named after the filter
+ * and parallel loop bodies attributed to its functions, and that each has
+ * exactly one entry with the same address and size in the perf map */
+static bool check_perf_map(Buffer<float> image, int tile_width) {
+    int width  = image.width();
+    int height = image.height();
+
+    std::stringstream filename;
+    filename << "/tmp/perf-" << getpid() << ".map";
+    std::remove(filename.str().c_str());
+
+    RecFilterDim x("x", width);
+    RecFilterDim y("y", height);
+
+    RecFilter F("PerfMap");
+    F(x, y) = image(x.var(), y.var());
+    F.add_filter(+x, {0.5f, 0.5f});
+    F.add_filter(-x, {0.5f, 0.5f});
+    F.add_filter(+y, {0.5f, 0.5f});
+    F.add_filter(-y, {0.5f, 0.5f});
+    F.split(x, tile_width, y, tile_width);
+    F.cpu_auto_schedule();
+    F.enable_perf_map();
+    F.realize();
+
+    vector<RecFilterSymbol> symbols = F.jit_symbols();
+    if (symbols.empty()) {
+        cerr << "Warning: JIT did not register its code, perf map not checked" << endl;
+        return true;
+    }
+
+    bool found_entry = false;
+    bool found_loop  = false;
+    for (int i=0; i<symbols.size(); i++) {
+        const RecFilterSymbol& s = symbols[i];
+        if (s.size == 0 || s.address == 0) {
+            cerr << "JIT symbol " << s.symbol << " has address " << s.address
+                << " and size " << s.size << endl;
+            return false;
+        }
+        if (i>0 && symbols[i-1].address + symbols[i-1].size > s.address) {
+            cerr << "JIT symbols " << symbols[i-1].symbol << " and " << s.symbol
+                << " overlap or are not sorted by address" << endl;
+            return false;
+        }
+        found_entry |= (s.symbol == "PerfMap");
+        found_loop  |= (s.symbol.compare(0, 8, "par_for_") == 0 && s.func_tag != "UNKNOWN");
+    }
+    if (!found_entry || !found_loop) {
+        cerr << "JIT symbols do not include the entry point of the filter or "
+            << "parallel loop bodies attributed to its functions" << endl;
+        return false;
+    }
+
+    std::ifstream fin(filename.str().c_str());
+    vector<string> lines;
+    for (string line; std::getline(fin, line); ) {
+        lines.push_back(line);
+    }
+    for (int i=0; i<symbols.size(); i++) {
+        std::stringstream entry;
+        entry << std::hex << symbols[i].address << " " << symbols[i].size << std::dec
+            << " recfilter::" << symbols[i].symbol << "[";
+        int count = 0;
+        for (int j=0; j<lines.size(); j++) {
+            count += (lines[j].compare(0, entry.str().size(), entry.str()) == 0);
+        }
+        if (count != 1) {
+            cerr << "Perf map has " << count << " entries for " << symbols[i].symbol
+                << " instead of 1" << endl;
+            return false;
+        }
+    }
+
+    // realizing again reuses the compiled code and writes no new entries
+    F.realize();
+    std::ifstream again(filename.str().c_str());
+    int num_lines = 0;
+    for (string line; std::getline(again, line); ) {
+        num_lines++;
+    }
+    if (num_lines != lines.size()) {
+        cerr << "Perf map grew from " << lines.size() << " to " << num_lines
+            << " entries without recompilation" << endl;
+        return false;
+    }
+
+    std::remove(filename.str().c_str());
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int width  = 64;
+    int height = 64;
+
+    RecFilter::set_vectorization_width(8);
+
+    Buffer<float> image(width, height);
+    for (int y=0; y<height; y++) {
+        for (int x=0; x<width; x++) {
+            image(x,y) = float(rand()) / RAND_MAX;
+        }
+    }
+
+    bool success = check_perf_map(image, 16);
+
+    if (success) {
+        cerr << "Success!" << endl;
+        return EXIT_SUCCESS;
+    }
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,92 @@
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <Halide.h>
+
+#include "builders.h"
+
+using namespace Halide;
+
+using std::cerr;
+using std::endl;
+using std::vector;
+
+/** Sum of a rectangle clipped to the image by direct summation */
+static double direct_sum(Buffer<int> image, RecFilterRect r) {
+    double sum = 0.0;
+    for (int y=std::max(r.y,0); y<std::min(r.y+r.height, image.height()); y++) {
+        for (int x=std::max(r.x,0); x<std::min(r.x+r.width, image.width()); x++) {
+            sum += image(x,y);
+        }
+    }
+    return sum;
+}
+
+/** Compare batched rectangle sums with direct summation for a number of
+ * queries that is not a multiple of the block or the vector width */
+static bool check_queries(RectangleSums& query, Buffer<int> image, Buffer<int> sat, int n, int block) {
+    vector<RecFilterRect> rects;
+    for (int i=0; i<n; i++) {
+        RecFilterRect r;
+        r.x      = rand() % (image.width()+8)  - 4;
+        r.y      = rand() % (image.height()+8) - 4;
+        r.width  = rand() % 16 + 1;
+        r.height = rand() % 16 + 1;
+        rects.push_back(r);
+    }
+
+    vector<double> sums = query(sat, rects);
+    if (int(sums.size()) != n) {
+        cerr << n << " queries with block " << block << " returned "
+            << sums.size() << " sums" << endl;
+        return false;
+    }
+    for (int i=0; i<n; i++) {
+        double expected = direct_sum(image, rects[i]);
+        if (sums[i] != expected) {
+            cerr << "Query " << i << " of " << n << " with block " << block
+                << " is " << sums[i] << " instead of " << expected << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int width  = 64;
+    int height = 48;
+
+    // integer image and its summed area table
+    Buffer<int> image(width, height);
+    Buffer<int> sat(width, height);
+    for (int y=0; y<height; y++) {
+        for (int x=0; x<width; x++) {
+            image(x,y) = rand() % 256;
+            sat(x,y) = image(x,y)
+                + (x>0 ? sat(x-1,y) : 0)
+                + (y>0 ? sat(x,y-1) : 0)
+                - (x>0 && y>0 ? sat(x-1,y-1) : 0);
+        }
+    }
+
+    bool success = true;
+
+    // fewer queries than a block and than a vector, and a partial last block
+    RectangleSums query(Int(32));
+    int sizes[] = { 1, 3, 100, 5000 };
+    for (int n : sizes) {
+        success &= check_queries(query, image, sat, n, 4096);
+    }
+
+    // blocks smaller than the vector width
+    RectangleSums small_blocks(Int(32), 3);
+    for (int n : sizes) {
+        success &= check_queries(small_blocks, image, sat, n, 3);
+    }
+
+    if (success) {
+        cerr << "Success!" << endl;
+        return EXIT_SUCCESS;
+    }
+    return EXIT_FAILURE;
+}
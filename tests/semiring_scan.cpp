@@ -0,0 +1,155 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <Halide.h>
+
+#include "builders.h"
+
+using namespace Halide;
+
+using std::cerr;
+using std::endl;
+using std::vector;
+
+/** Scan y[n] = max(x[n], y[n-1]+w) or min(x[n], y[n-1]+w) along the rows
+ * (dimension 0) or columns (dimension 1) of an image by direct evaluation */
+static vector<double> direct_semiring_scan(
+        Buffer<float> image,
+        int dimension,
+        bool causal,
+        RecFilterSemiring op,
+        float weight)
+{
+    int width  = image.width();
+    int height = image.height();
+    int n = (dimension==0 ? width : height);
+    int m = (dimension==0 ? height : width);
+
+    vector<double> out(width*height);
+    for (int j=0; j<m; j++) {
+        double prev = 0.0;
+        for (int t=0; t<n; t++) {
+            int i = (causal ? t : n-1-t);
+            int px = (dimension==0 ? i : j);
+            int py = (dimension==0 ? j : i);
+            double v = image(px, py);
+            if (t > 0) {
+                v = (op==MAX_PLUS ? std::max(v, prev+weight) : std::min(v, prev+weight));
+            }
+            out[py*width+px] = v;
+            prev = v;
+        }
+    }
+    return out;
+}
+
+/** Compare the tiled semiring scan with the direct scan; inputs and weights
+ * are small dyadic numbers so that both are exact */
+static bool check_semiring_scan(
+        Buffer<float> image,
+        int dimension,
+        bool causal,
+        RecFilterSemiring op,
+        float weight,
+        int tile_width)
+{
+    int width  = image.width();
+    int height = image.height();
+
+    RecFilterDim x("x", width);
+    RecFilterDim y("y", height);
+
+    Func I("Image");
+    I(x.var(), y.var()) = image(x.var(), y.var());
+
+    RecFilterDim d = (dimension==0 ? x : y);
+    Func S = semiring_scan(I, x, y, (causal ? +d : -d), op, weight, tile_width, "Scan");
+    Buffer<float> out = S.realize({width, height});
+
+    vector<double> ref = direct_semiring_scan(image, dimension, causal, op, weight);
+
+    for (int j=0; j<height; j++) {
+        for (int i=0; i<width; i++) {
+            if (out(i,j) != ref[j*width+i]) {
+                cerr << (op==MAX_PLUS ? "Max" : "Min") << "-plus scan along "
+                    << (causal ? "+" : "-") << (dimension==0 ? "x" : "y")
+                    << " with weight " << weight << " and tile width " << tile_width
+                    << " at (" << i << "," << j << ") is " << out(i,j)
+                    << " instead of " << ref[j*width+i] << endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/** Compare the distance transform with the brute force L1 distance to the
+ * nearest pixel of a sparse mask */
+static bool check_distance_transform(int width, int height, int tile_width) {
+    Buffer<uint8_t> mask(width, height);
+    mask.fill(0);
+    for (int i=0; i<8; i++) {
+        mask(rand() % width, rand() % height) = 1;
+    }
+
+    RecFilterDim x("x", width);
+    RecFilterDim y("y", height);
+
+    Func M("Mask");
+    M(x.var(), y.var()) = mask(x.var(), y.var());
+
+    Func D = distance_transform(M, x, y, tile_width, "Distance");
+    Buffer<float> out = D.realize({width, height});
+
+    for (int j=0; j<height; j++) {
+        for (int i=0; i<width; i++) {
+            int expected = width+height;
+            for (int v=0; v<height; v++) {
+                for (int u=0; u<width; u++) {
+                    if (mask(u,v)) {
+                        expected = std::min(expected, std::abs(u-i) + std::abs(v-j));
+                    }
+                }
+            }
+            if (out(i,j) != expected) {
+                cerr << "Distance transform at (" << i << "," << j << ") is "
+                    << out(i,j) << " instead of " << expected << endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int width  = 64;
+    int height = 48;
+
+    RecFilter::set_vectorization_width(8);
+
+    Buffer<float> image(width, height);
+    for (int y=0; y<height; y++) {
+        for (int x=0; x<width; x++) {
+            image(x,y) = float(rand() % 256);
+        }
+    }
+
+    bool success = true;
+
+    for (int d=0; d<2; d++) {
+        for (int c=0; c<2; c++) {
+            success &= check_semiring_scan(image, d, c, MAX_PLUS, -4.0f,  16);
+            success &= check_semiring_scan(image, d, c, MIN_PLUS,  2.5f,  16);
+            success &= check_semiring_scan(image, d, c, MIN_PLUS,  0.25f, 8);
+        }
+    }
+
+    success &= check_distance_transform(width, height, 16);
+
+    if (success) {
+        cerr << "Success!" << endl;
+        return EXIT_SUCCESS;
+    }
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,143 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <Halide.h>
+
+#include "recfilter.h"
+
+using namespace Halide;
+
+using std::cerr;
+using std::endl;
+using std::vector;
+
+/** ARMA scan along a row by direct evaluation in double with zero border;
+ * the anticausal scan reads x[n+k] and y[n+j+1] */
+static vector<double> direct_arma_row(
+        const vector<double>& in,
+        bool causal,
+        const vector<float>& b,
+        const vector<float>& a)
+{
+    int n = in.size();
+    vector<double> out(n, 0.0);
+    for (int t=0; t<n; t++) {
+        int i = (causal ? t : n-1-t);
+        int s = (causal ? -1 : 1);
+        double v = 0.0;
+        for (int k=0; k<b.size() && k<=t; k++) {
+            v += b[k] * in[i+s*k];
+        }
+        for (int k=0; k<a.size() && k<t; k++) {
+            v += a[k] * out[i+s*(k+1)];
+        }
+        out[i] = v;
+    }
+    return out;
+}
+
+/** Compare the sum-form symmetric filter along x, optionally followed by a
+ * causal scan along y, with the sum of the direct causal and anticausal
+ * branches */
+static bool check_symmetric_filter(
+        Buffer<float> in,
+        int tile_width,
+        const vector<float>& causal_b,
+        const vector<float>& anticausal_b,
+        const vector<float>& a,
+        bool scan_y)
+{
+    int width  = in.width();
+    int height = in.height();
+
+    vector<float> y_coeff = { 0.5f, 0.5f };
+
+    RecFilterDim x("x", width);
+    RecFilterDim y("y", height);
+
+    RecFilter F("Symmetric");
+    F(x, y) = in(x.var(), y.var());
+    F.add_symmetric_filter(x, causal_b, anticausal_b, a);
+    if (scan_y) {
+        F.add_filter(+y, y_coeff);
+    }
+    F.split(x, tile_width, y, tile_width);
+    F.cpu_auto_schedule();
+    Buffer<float> out = F.realize();
+
+    vector<double> ref(width*height);
+    for (int j=0; j<height; j++) {
+        vector<double> row(width);
+        for (int i=0; i<width; i++) {
+            row[i] = in(i,j);
+        }
+        vector<double> c = direct_arma_row(row, true,  causal_b,     a);
+        vector<double> d = direct_arma_row(row, false, anticausal_b, a);
+        for (int i=0; i<width; i++) {
+            ref[j*width+i] = c[i] + d[i];
+        }
+    }
+    if (scan_y) {
+        for (int i=0; i<width; i++) {
+            vector<double> col(height);
+            for (int j=0; j<height; j++) {
+                col[j] = ref[j*width+i];
+            }
+            col = direct_arma_row(col, true, {y_coeff[0]}, {y_coeff[1]});
+            for (int j=0; j<height; j++) {
+                ref[j*width+i] = col[j];
+            }
+        }
+    }
+
+    double max_ref = 0.0;
+    for (int i=0; i<width*height; i++) {
+        max_ref = std::max(max_ref, std::abs(ref[i]));
+    }
+
+    for (int j=0; j<height; j++) {
+        for (int i=0; i<width; i++) {
+            double e = ref[j*width+i];
+            if (std::abs(out(i,j)-e) > 1e-4*max_ref) {
+                cerr << "Symmetric filter with tile width " << tile_width
+                    << (scan_y ? " and scan in y" : "") << " at (" << i << "," << j
+                    << ") is " << out(i,j) << " instead of " << e << endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int width  = 64;
+    int height = 64;
+
+    RecFilter::set_vectorization_width(8);
+
+    Buffer<float> in(width, height);
+    for (int y=0; y<height; y++) {
+        for (int x=0; x<width; x++) {
+            in(x,y) = float(rand()) / RAND_MAX;
+        }
+    }
+
+    // sum-form second order filter with poles of radius 0.7, the anticausal
+    // branch starts at x+1 so that x is counted once
+    vector<float> causal_b     = { 0.5f, 0.2f };
+    vector<float> anticausal_b = { 0.0f, 0.3f, 0.1f };
+    vector<float> a            = { 0.9f, -0.49f };
+
+    bool success = true;
+
+    success &= check_symmetric_filter(in, 16, causal_b, anticausal_b, a, false);
+    success &= check_symmetric_filter(in, 16, causal_b, anticausal_b, a, true);
+    success &= check_symmetric_filter(in, 32, causal_b, anticausal_b, a, true);
+
+    if (success) {
+        cerr << "Success!" << endl;
+        return EXIT_SUCCESS;
+    }
+    return EXIT_FAILURE;
+}